@@ -0,0 +1,447 @@
+#include "pch.h"
+#include "synth.h"
+
+#if defined(_WIN32) || defined(_WIN64)
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace cppwinrt::benchmark
+{
+    using clock = std::chrono::high_resolution_clock;
+
+    struct writer : writer_base<writer>
+    {
+    };
+
+    struct usage_exception {};
+
+    static constexpr option command_options[]
+    {
+        { "cppwinrt", 0, 1, "<path>", "cppwinrt executable to measure (defaults to the one built alongside)" },
+        { "output", 0, 1, "<path>", "Working folder for metadata and projections (defaults to cppwinrt-benchmark)" },
+        { "scale", 0, option::no_max, "<factor>", "Multiples of the base metadata to measure (defaults to 1 2 4 8)" },
+        { "namespaces", 0, 1, "<count>", "Namespaces at a scale of one (defaults to 10)" },
+        { "runs", 0, 1, "<count>", "Runs per scale, of which the fastest is reported (defaults to 3)" },
+        { "jobs", 0, 1, "<count>", "Passed on to cppwinrt to limit its worker threads" },
+        { "csv", 0, 1, "<path>", "Also write the results as comma separated values" },
+        { "help", 0, option::no_max, {}, "Show detailed help" },
+        { "?", 0, option::no_max, {}, {} },
+    };
+
+    struct process_result
+    {
+        int exit_code{};
+        uint64_t peak_memory{};
+    };
+
+    struct scale_result
+    {
+        uint32_t scale{};
+        uint32_t namespaces{};
+        size_t types{};
+        uint64_t input_size{};
+        uint64_t output_size{};
+        clock::duration elapsed{};
+        uint64_t peak_memory{};
+        std::map<std::string, int64_t> phases; // microseconds
+    };
+
+    static void print_usage(writer& w)
+    {
+        w.write("\n  cppwinrt-benchmark [options...]\n\nOptions:\n\n");
+
+        for (auto&& opt : command_options)
+        {
+            if (!opt.desc.empty())
+            {
+                w.write_printf("  %-20s%s\n", w.write_temp("-% %", opt.name, opt.arg).c_str(), opt.desc.data());
+            }
+        }
+
+        w.write(R"(
+Each scale multiplies the number of namespaces and metadata files, keeping the shape of each
+namespace fixed. cppwinrt is run with -profile so that the time spent in each phase is reported
+along with the wall clock time, throughput and peak memory use of the whole run.
+)");
+    }
+
+    static uint32_t get_positive_value(reader const& args, std::string_view const& name, uint32_t default_value)
+    {
+        if (!args.exists(name))
+        {
+            return default_value;
+        }
+
+        auto value = args.value(name);
+        char* end{};
+        auto result = strtoul(value.c_str(), &end, 10);
+
+        if (value.empty() || *end || result == 0 || result > UINT32_MAX)
+        {
+            throw_invalid("Option '", name, "' requires a positive number");
+        }
+
+        return static_cast<uint32_t>(result);
+    }
+
+    // Runs a process to completion with its output discarded, returning its exit code and the
+    // most memory it had resident at any one time.
+    static process_result run_process(std::vector<std::string> const& command)
+    {
+        process_result result;
+
+#if defined(_WIN32) || defined(_WIN64)
+        std::string command_line;
+
+        for (auto&& arg : command)
+        {
+            command_line += command_line.empty() ? "\"" : " \"";
+            command_line += arg;
+            command_line += '"';
+        }
+
+        SECURITY_ATTRIBUTES security{ sizeof(security), nullptr, true };
+        HANDLE null_file = CreateFileA("NUL", GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, &security, OPEN_EXISTING, 0, nullptr);
+        STARTUPINFOA startup{ sizeof(startup) };
+        startup.dwFlags = STARTF_USESTDHANDLES;
+        startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        startup.hStdOutput = null_file;
+        startup.hStdError = null_file;
+        PROCESS_INFORMATION process{};
+
+        if (!CreateProcessA(nullptr, command_line.data(), nullptr, nullptr, true, 0, nullptr, nullptr, &startup, &process))
+        {
+            CloseHandle(null_file);
+            throw_invalid("Could not run '", command[0], "'");
+        }
+
+        WaitForSingleObject(process.hProcess, INFINITE);
+        DWORD exit_code{};
+        GetExitCodeProcess(process.hProcess, &exit_code);
+        PROCESS_MEMORY_COUNTERS memory{ sizeof(memory) };
+
+        if (GetProcessMemoryInfo(process.hProcess, &memory, sizeof(memory)))
+        {
+            result.peak_memory = memory.PeakWorkingSetSize;
+        }
+
+        CloseHandle(process.hThread);
+        CloseHandle(process.hProcess);
+        CloseHandle(null_file);
+        result.exit_code = static_cast<int>(exit_code);
+#else
+        std::vector<char*> argv;
+
+        for (auto&& arg : command)
+        {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+
+        argv.push_back(nullptr);
+        pid_t const pid = fork();
+
+        if (pid == -1)
+        {
+            throw_invalid("Could not run '", command[0], "'");
+        }
+
+        if (pid == 0)
+        {
+            int null_file = open("/dev/null", O_WRONLY);
+            dup2(null_file, STDOUT_FILENO);
+            dup2(null_file, STDERR_FILENO);
+            execv(argv[0], argv.data());
+            _exit(127);
+        }
+
+        int status{};
+        rusage usage{};
+
+        if (wait4(pid, &status, 0, &usage) == -1)
+        {
+            throw_invalid("Could not wait for '", command[0], "'");
+        }
+
+        result.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#if defined(__APPLE__)
+        result.peak_memory = static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        result.peak_memory = static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+
+        return result;
+    }
+
+    static uint64_t get_folder_size(std::filesystem::path const& folder)
+    {
+        uint64_t size{};
+
+        for (auto&& file : std::filesystem::recursive_directory_iterator(folder))
+        {
+            if (file.is_regular_file())
+            {
+                size += file.file_size();
+            }
+        }
+
+        return size;
+    }
+
+    static std::string_view get_field(std::string_view const& line, std::string_view const& name)
+    {
+        auto pos = line.find(name);
+
+        if (pos == std::string_view::npos)
+        {
+            return {};
+        }
+
+        auto value = line.substr(pos + name.size());
+        return value.substr(0, value.find_first_of("\",}"));
+    }
+
+    // Reads back the trace written by cppwinrt -profile, which has one event per line. Phases
+    // are reported as they are timed on the main thread, while the time spent writing namespace
+    // headers and flushing them to disk is added up across all of the threads.
+    static std::map<std::string, int64_t> read_trace(std::filesystem::path const& filename)
+    {
+        std::map<std::string, int64_t> phases;
+        std::ifstream file(filename);
+        std::string line;
+
+        while (std::getline(file, line))
+        {
+            auto const category = get_field(line, "\"cat\":\"");
+            auto const duration = get_field(line, "\"dur\":");
+
+            if (category.empty() || duration.empty())
+            {
+                continue;
+            }
+
+            auto const name = category == "phase" ? get_field(line, "\"name\":\"") : category;
+            phases[std::string{ name }] += std::strtoll(std::string{ duration }.c_str(), nullptr, 10);
+        }
+
+        return phases;
+    }
+
+    static scale_result measure(reader const& args, std::filesystem::path const& folder, uint32_t scale)
+    {
+        synth::options shape;
+        shape.namespaces = get_positive_value(args, "namespaces", 10) * scale;
+        shape.files = 2 * scale;
+        shape.interfaces = 30;
+        shape.classes = 15;
+        shape.enums = 6;
+        shape.structs = 6;
+        shape.delegates = 6;
+        shape.generics = 4;
+        shape.methods = 8;
+        shape.properties = 4;
+        shape.events = 2;
+        shape.attributes = 2;
+
+        auto const scale_folder = folder / ("scale" + std::to_string(scale));
+        auto const input = scale_folder / "winmd";
+        auto const output = scale_folder / "projection";
+        auto const trace = scale_folder / "trace.json";
+        std::filesystem::remove_all(scale_folder);
+
+        scale_result result;
+        result.scale = scale;
+        result.namespaces = shape.namespaces;
+        result.types = synth::write_files(shape, input);
+        result.input_size = get_folder_size(input);
+
+        std::vector<std::string> command{ args.value("cppwinrt", CPPWINRT_BENCHMARK_EXECUTABLE), "-input", input.string(), "-output", output.string(), "-profile", trace.string() };
+
+        if (args.exists("jobs"))
+        {
+            command.push_back("-jobs");
+            command.push_back(args.value("jobs"));
+        }
+
+        auto const runs = get_positive_value(args, "runs", 3);
+
+        for (uint32_t run = 0; run < runs; ++run)
+        {
+            // Every run writes the whole projection rather than finding it already up to date.
+            std::filesystem::remove_all(output);
+            auto const start = clock::now();
+            auto const process = run_process(command);
+            auto const elapsed = clock::now() - start;
+
+            if (process.exit_code != 0)
+            {
+                throw_invalid("'", command[0], "' failed with exit code ", std::to_string(process.exit_code));
+            }
+
+            result.peak_memory = (std::max)(result.peak_memory, process.peak_memory);
+
+            if (run == 0 || elapsed < result.elapsed)
+            {
+                result.elapsed = elapsed;
+                result.phases = read_trace(trace);
+            }
+        }
+
+        result.output_size = get_folder_size(output);
+        return result;
+    }
+
+    static double to_milliseconds(int64_t microseconds)
+    {
+        return microseconds / 1000.0;
+    }
+
+    static void write_results(writer& w, std::vector<scale_result> const& results)
+    {
+        w.write_printf("%6s %6s %8s %9s %9s %9s %10s %8s %9s %9s %9s %9s %9s\n",
+            "scale", "ns", "types", "in MB", "out MB", "wall ms", "types/s", "out MB/s", "peak MB", "cache ms", "base ms", "ns cpu ms", "io ms");
+
+        for (auto&& result : results)
+        {
+            auto const seconds = std::chrono::duration<double>(result.elapsed).count();
+            auto const phase = [&](std::string const& name)
+            {
+                auto found = result.phases.find(name);
+                return to_milliseconds(found == result.phases.end() ? 0 : found->second);
+            };
+
+            w.write_printf("%6u %6u %8zu %9.2f %9.2f %9.1f %10.0f %8.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n",
+                result.scale,
+                result.namespaces,
+                result.types,
+                result.input_size / 1048576.0,
+                result.output_size / 1048576.0,
+                seconds * 1000,
+                result.types / seconds,
+                result.output_size / 1048576.0 / seconds,
+                result.peak_memory / 1048576.0,
+                phase("cache"),
+                phase("base.h"),
+                phase("namespace"),
+                phase("io"));
+        }
+    }
+
+    static void write_csv(std::string const& filename, std::vector<scale_result> const& results)
+    {
+        std::set<std::string> phases;
+
+        for (auto&& result : results)
+        {
+            for (auto&& [name, elapsed] : result.phases)
+            {
+                phases.insert(name);
+            }
+        }
+
+        writer w;
+        w.write("scale,namespaces,types,input_bytes,output_bytes,wall_us,peak_bytes");
+
+        for (auto&& name : phases)
+        {
+            w.write(",%_us", name);
+        }
+
+        w.write('\n');
+
+        for (auto&& result : results)
+        {
+            w.write("%,%,%,%,%,%,%",
+                result.scale,
+                result.namespaces,
+                static_cast<uint64_t>(result.types),
+                result.input_size,
+                result.output_size,
+                static_cast<int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(result.elapsed).count()),
+                result.peak_memory);
+
+            for (auto&& name : phases)
+            {
+                auto found = result.phases.find(name);
+                w.write(",%", found == result.phases.end() ? int64_t{} : found->second);
+            }
+
+            w.write('\n');
+        }
+
+        w.flush_to_file(filename);
+    }
+
+    static int run(int const argc, char** argv)
+    {
+        writer w;
+
+        try
+        {
+            reader args{ argc, argv, command_options };
+
+            if (args.exists("help") || args.exists("?"))
+            {
+                throw usage_exception{};
+            }
+
+            std::vector<uint32_t> scales;
+
+            for (auto&& value : args.values("scale"))
+            {
+                char* end{};
+                auto scale = strtoul(value.c_str(), &end, 10);
+
+                if (value.empty() || *end || scale == 0 || scale > UINT16_MAX)
+                {
+                    throw_invalid("Option 'scale' requires positive numbers");
+                }
+
+                scales.push_back(static_cast<uint32_t>(scale));
+            }
+
+            if (scales.empty())
+            {
+                scales = { 1, 2, 4, 8 };
+            }
+
+            std::filesystem::path const folder = args.value("output", "cppwinrt-benchmark");
+            std::vector<scale_result> results;
+
+            for (auto scale : scales)
+            {
+                results.push_back(measure(args, folder, scale));
+            }
+
+            write_results(w, results);
+
+            if (args.exists("csv"))
+            {
+                write_csv(args.value("csv"), results);
+            }
+        }
+        catch (usage_exception const&)
+        {
+            print_usage(w);
+        }
+        catch (std::exception const& e)
+        {
+            w.write("cppwinrt-benchmark : error %\n", e.what());
+            w.flush_to_console(false);
+            return 1;
+        }
+
+        w.flush_to_console();
+        return 0;
+    }
+}
+
+int main(int const argc, char** argv)
+{
+    return cppwinrt::benchmark::run(argc, argv);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <winmd_reader.h>
+#include "cmd_reader.h"
+#include "text_writer.h"
@@ -0,0 +1,112 @@
+#include "pch.h"
+#include "synth.h"
+
+namespace cppwinrt::synth
+{
+    struct writer : writer_base<writer>
+    {
+    };
+
+    struct usage_exception {};
+
+    static constexpr option command_options[]
+    {
+        { "output", 0, 1, "<path>", "Folder to write the winmd files to (defaults to the current folder)" },
+        { "files", 0, 1, "<count>", "Number of winmd files to spread the namespaces across" },
+        { "namespaces", 0, 1, "<count>", "Number of namespaces" },
+        { "interfaces", 0, 1, "<count>", "Interfaces per namespace, not counting those of runtime classes" },
+        { "classes", 0, 1, "<count>", "Runtime classes per namespace, each with a default and a statics interface" },
+        { "enums", 0, 1, "<count>", "Enums per namespace, the first of which is a flags enum" },
+        { "structs", 0, 1, "<count>", "Structs per namespace" },
+        { "delegates", 0, 1, "<count>", "Delegates per namespace" },
+        { "generics", 0, 1, "<count>", "Generic interfaces per namespace, used by methods and runtime classes" },
+        { "methods", 0, 1, "<count>", "Methods per interface" },
+        { "properties", 0, 1, "<count>", "Properties per interface" },
+        { "events", 0, 1, "<count>", "Events per interface" },
+        { "attributes", 0, 1, "<count>", "Custom attribute types per namespace, applied to interfaces" },
+        { "help", 0, option::no_max, {}, "Show detailed help" },
+        { "?", 0, option::no_max, {}, {} },
+    };
+
+    static void print_usage(writer& w)
+    {
+        w.write("\n  cppwinrt-synth [options...]\n\nOptions:\n\n");
+
+        for (auto&& opt : command_options)
+        {
+            if (!opt.desc.empty())
+            {
+                w.write_printf("  %-20s%s\n", w.write_temp("-% %", opt.name, opt.arg).c_str(), opt.desc.data());
+            }
+        }
+    }
+
+    static void get_count(reader const& args, std::string_view const& name, uint32_t& count)
+    {
+        if (!args.exists(name))
+        {
+            return;
+        }
+
+        auto value = args.value(name);
+        char* end{};
+        auto result = strtoul(value.c_str(), &end, 10);
+
+        if (value.empty() || *end || result > UINT32_MAX)
+        {
+            throw_invalid("Option '", name, "' requires a number");
+        }
+
+        count = static_cast<uint32_t>(result);
+    }
+
+    static int run(int const argc, char** argv)
+    {
+        writer w;
+
+        try
+        {
+            reader args{ argc, argv, command_options };
+
+            if (args.exists("help") || args.exists("?"))
+            {
+                throw usage_exception{};
+            }
+
+            options o;
+            get_count(args, "files", o.files);
+            get_count(args, "namespaces", o.namespaces);
+            get_count(args, "interfaces", o.interfaces);
+            get_count(args, "classes", o.classes);
+            get_count(args, "enums", o.enums);
+            get_count(args, "structs", o.structs);
+            get_count(args, "delegates", o.delegates);
+            get_count(args, "generics", o.generics);
+            get_count(args, "methods", o.methods);
+            get_count(args, "properties", o.properties);
+            get_count(args, "events", o.events);
+            get_count(args, "attributes", o.attributes);
+
+            auto const types = write_files(o, args.value("output", "."));
+            w.write("Wrote % types\n", static_cast<uint64_t>(types));
+        }
+        catch (usage_exception const&)
+        {
+            print_usage(w);
+        }
+        catch (std::exception const& e)
+        {
+            w.write("cppwinrt-synth : error %\n", e.what());
+            w.flush_to_console(false);
+            return 1;
+        }
+
+        w.flush_to_console();
+        return 0;
+    }
+}
+
+int main(int const argc, char** argv)
+{
+    return cppwinrt::synth::run(argc, argv);
+}
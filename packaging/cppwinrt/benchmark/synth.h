@@ -0,0 +1,1059 @@
+#pragma once
+
+namespace cppwinrt::synth
+{
+    using namespace winmd::reader;
+
+    // Counts of each kind of type written per namespace, apart from files and namespaces.
+    struct options
+    {
+        uint32_t files{ 2 };
+        uint32_t namespaces{ 4 };
+        uint32_t interfaces{ 8 };
+        uint32_t classes{ 4 };
+        uint32_t enums{ 2 };
+        uint32_t structs{ 2 };
+        uint32_t delegates{ 2 };
+        uint32_t generics{ 1 };
+        uint32_t methods{ 4 };
+        uint32_t properties{ 2 };
+        uint32_t events{ 1 };
+        uint32_t attributes{ 1 };
+    };
+
+    namespace table_id
+    {
+        enum : uint32_t
+        {
+            Module = 0x00,
+            TypeRef = 0x01,
+            TypeDef = 0x02,
+            Field = 0x04,
+            MethodDef = 0x06,
+            Param = 0x08,
+            InterfaceImpl = 0x09,
+            MemberRef = 0x0a,
+            Constant = 0x0b,
+            CustomAttribute = 0x0c,
+            DeclSecurity = 0x0e,
+            StandAloneSig = 0x11,
+            EventMap = 0x12,
+            Event = 0x14,
+            PropertyMap = 0x15,
+            Property = 0x17,
+            MethodSemantics = 0x18,
+            ModuleRef = 0x1a,
+            TypeSpec = 0x1b,
+            Assembly = 0x20,
+            AssemblyRef = 0x23,
+            File = 0x26,
+            ExportedType = 0x27,
+            ManifestResource = 0x28,
+            GenericParam = 0x2a,
+            MethodSpec = 0x2b,
+            GenericParamConstraint = 0x2c,
+        };
+    }
+
+    struct coded_kind
+    {
+        uint32_t bits;
+        std::vector<uint32_t> tables;
+    };
+
+    // The tables are listed in tag order, as in winmd::reader::database::initialize.
+    inline coded_kind const coded_TypeDefOrRef{ 2, { table_id::TypeDef, table_id::TypeRef, table_id::TypeSpec } };
+    inline coded_kind const coded_HasConstant{ 2, { table_id::Field, table_id::Param, table_id::Property } };
+    inline coded_kind const coded_HasCustomAttribute{ 5, { table_id::MethodDef, table_id::Field, table_id::TypeRef, table_id::TypeDef, table_id::Param,
+        table_id::InterfaceImpl, table_id::MemberRef, table_id::Module, table_id::DeclSecurity, table_id::Property, table_id::Event, table_id::StandAloneSig,
+        table_id::ModuleRef, table_id::TypeSpec, table_id::Assembly, table_id::AssemblyRef, table_id::File, table_id::ExportedType,
+        table_id::ManifestResource, table_id::GenericParam, table_id::GenericParamConstraint, table_id::MethodSpec } };
+    inline coded_kind const coded_MemberRefParent{ 3, { table_id::TypeDef, table_id::TypeRef, table_id::ModuleRef, table_id::MethodDef, table_id::TypeSpec } };
+    inline coded_kind const coded_HasSemantics{ 1, { table_id::Event, table_id::Property } };
+    inline coded_kind const coded_CustomAttributeType{ 3, { table_id::MethodDef, table_id::MemberRef } };
+    inline coded_kind const coded_ResolutionScope{ 2, { table_id::Module, table_id::ModuleRef, table_id::AssemblyRef, table_id::TypeRef } };
+    inline coded_kind const coded_TypeOrMethodDef{ 1, { table_id::TypeDef, table_id::MethodDef } };
+
+    struct column
+    {
+        enum kind_type { fixed, string, guid, blob, index, coded } kind;
+        uint32_t size{};
+        uint32_t table{};
+        coded_kind const* coded_index{};
+    };
+
+    inline column fixed(uint32_t size) { return { column::fixed, size }; }
+    inline column str() { return { column::string }; }
+    inline column guid() { return { column::guid }; }
+    inline column blob() { return { column::blob }; }
+    inline column index(uint32_t table) { return { column::index, 0, table }; }
+    inline column coded(coded_kind const& kind) { return { column::coded, 0, 0, &kind }; }
+
+    inline std::map<uint32_t, std::vector<column>> const& schema()
+    {
+        static std::map<uint32_t, std::vector<column>> const columns
+        {
+            { table_id::Module, { fixed(2), str(), guid(), guid(), guid() } },
+            { table_id::TypeRef, { coded(coded_ResolutionScope), str(), str() } },
+            { table_id::TypeDef, { fixed(4), str(), str(), coded(coded_TypeDefOrRef), index(table_id::Field), index(table_id::MethodDef) } },
+            { table_id::Field, { fixed(2), str(), blob() } },
+            { table_id::MethodDef, { fixed(4), fixed(2), fixed(2), str(), blob(), index(table_id::Param) } },
+            { table_id::Param, { fixed(2), fixed(2), str() } },
+            { table_id::InterfaceImpl, { index(table_id::TypeDef), coded(coded_TypeDefOrRef) } },
+            { table_id::MemberRef, { coded(coded_MemberRefParent), str(), blob() } },
+            { table_id::Constant, { fixed(2), coded(coded_HasConstant), blob() } },
+            { table_id::CustomAttribute, { coded(coded_HasCustomAttribute), coded(coded_CustomAttributeType), blob() } },
+            { table_id::EventMap, { index(table_id::TypeDef), index(table_id::Event) } },
+            { table_id::Event, { fixed(2), str(), coded(coded_TypeDefOrRef) } },
+            { table_id::PropertyMap, { index(table_id::TypeDef), index(table_id::Property) } },
+            { table_id::Property, { fixed(2), str(), blob() } },
+            { table_id::MethodSemantics, { fixed(2), index(table_id::MethodDef), coded(coded_HasSemantics) } },
+            { table_id::TypeSpec, { blob() } },
+            { table_id::Assembly, { fixed(4), fixed(8), fixed(4), blob(), str(), str() } },
+            { table_id::AssemblyRef, { fixed(8), fixed(4), blob(), str(), str(), blob() } },
+            { table_id::GenericParam, { fixed(2), fixed(2), coded(coded_TypeOrMethodDef), str() } },
+        };
+
+        return columns;
+    }
+
+    inline void compress_unsigned(std::string& out, uint32_t const value)
+    {
+        if (value < 0x80)
+        {
+            out += static_cast<char>(value);
+        }
+        else if (value < 0x4000)
+        {
+            out += static_cast<char>(0x80 | (value >> 8));
+            out += static_cast<char>(value & 0xff);
+        }
+        else
+        {
+            out += static_cast<char>(0xc0 | (value >> 24));
+            out += static_cast<char>((value >> 16) & 0xff);
+            out += static_cast<char>((value >> 8) & 0xff);
+            out += static_cast<char>(value & 0xff);
+        }
+    }
+
+    template <typename T>
+    void append(std::string& out, T const value)
+    {
+        out.append(reinterpret_cast<char const*>(&value), sizeof(T));
+    }
+
+    inline void append_ser_string(std::string& out, std::string_view const& value)
+    {
+        compress_unsigned(out, static_cast<uint32_t>(value.size()));
+        out += value;
+    }
+
+    inline void align(std::string& out, size_t const alignment)
+    {
+        out.resize((out.size() + alignment - 1) / alignment * alignment);
+    }
+
+    struct file_builder
+    {
+        file_builder()
+        {
+            m_strings.push_back(0);
+            m_blobs.push_back(0);
+        }
+
+        uint32_t string(std::string_view const& value)
+        {
+            if (value.empty())
+            {
+                return 0;
+            }
+
+            auto [pos, inserted] = m_string_index.try_emplace(std::string{ value }, static_cast<uint32_t>(m_strings.size()));
+
+            if (inserted)
+            {
+                m_strings += value;
+                m_strings.push_back(0);
+            }
+
+            return pos->second;
+        }
+
+        uint32_t blob(std::string const& value)
+        {
+            auto [pos, inserted] = m_blob_index.try_emplace(value, static_cast<uint32_t>(m_blobs.size()));
+
+            if (inserted)
+            {
+                compress_unsigned(m_blobs, static_cast<uint32_t>(value.size()));
+                m_blobs += value;
+            }
+
+            return pos->second;
+        }
+
+        uint32_t guid(std::array<uint8_t, 16> const& value)
+        {
+            m_guids.append(reinterpret_cast<char const*>(value.data()), value.size());
+            return static_cast<uint32_t>(m_guids.size() / 16);
+        }
+
+        uint32_t add_row(uint32_t const table, std::vector<uint32_t> values)
+        {
+            auto& rows = m_tables[table];
+            rows.push_back(std::move(values));
+            return static_cast<uint32_t>(rows.size());
+        }
+
+        uint32_t row_count(uint32_t const table) const
+        {
+            auto rows = m_tables.find(table);
+            return rows == m_tables.end() ? 0 : static_cast<uint32_t>(rows->second.size());
+        }
+
+        uint32_t encode(coded_kind const& kind, uint32_t const table, uint32_t const row) const
+        {
+            auto tag = std::find(kind.tables.begin(), kind.tables.end(), table) - kind.tables.begin();
+
+            if (&kind == &coded_CustomAttributeType)
+            {
+                tag += 2;
+            }
+
+            return (row << kind.bits) | static_cast<uint32_t>(tag);
+        }
+
+        // Some tables must be sorted by their parent column, but are easier to fill in any order.
+        void sort(uint32_t const table, size_t const key)
+        {
+            auto& rows = m_tables[table];
+            std::stable_sort(rows.begin(), rows.end(), [&](auto&& left, auto&& right)
+            {
+                return left[key] < right[key];
+            });
+        }
+
+        std::string metadata() const
+        {
+            std::string tables;
+            append<uint32_t>(tables, 0);
+            append<uint8_t>(tables, 2);
+            append<uint8_t>(tables, 0);
+            append<uint8_t>(tables, 0x07); // Every heap uses four byte indexes.
+            append<uint8_t>(tables, 1);
+            uint64_t valid{};
+
+            for (auto&& [table, rows] : m_tables)
+            {
+                if (!rows.empty())
+                {
+                    valid |= uint64_t{ 1 } << table;
+                }
+            }
+
+            append<uint64_t>(tables, valid);
+            append<uint64_t>(tables, 0);
+
+            for (auto&& [table, rows] : m_tables)
+            {
+                if (!rows.empty())
+                {
+                    append<uint32_t>(tables, static_cast<uint32_t>(rows.size()));
+                }
+            }
+
+            for (auto&& [table, rows] : m_tables)
+            {
+                auto const& columns = schema().at(table);
+
+                for (auto&& row : rows)
+                {
+                    for (size_t column_index = 0; column_index < columns.size(); ++column_index)
+                    {
+                        auto const& column = columns[column_index];
+                        auto const value = row[column_index];
+                        uint32_t size{ 4 };
+
+                        switch (column.kind)
+                        {
+                        case column::fixed: size = column.size; break;
+                        case column::index: size = row_count(column.table) < (1u << 16) ? 2 : 4; break;
+                        case column::coded: size = coded_size(*column.coded_index); break;
+                        default: break;
+                        }
+
+                        if (size == 8)
+                        {
+                            append<uint64_t>(tables, value);
+                        }
+                        else
+                        {
+                            tables.append(reinterpret_cast<char const*>(&value), size);
+                        }
+                    }
+                }
+            }
+
+            std::string strings = m_strings;
+            std::string blobs = m_blobs;
+            std::string guids = m_guids;
+            align(tables, 4);
+            align(strings, 4);
+            align(blobs, 4);
+            std::string user_strings(4, 0);
+
+            std::string_view const version = "WindowsRuntime 1.4";
+            std::string root;
+            append<uint32_t>(root, 0x424a5342);
+            append<uint16_t>(root, 1);
+            append<uint16_t>(root, 1);
+            append<uint32_t>(root, 0);
+            append<uint32_t>(root, 20);
+            root += version;
+            root.resize(16 + 20);
+            append<uint16_t>(root, 0);
+
+            std::pair<std::string_view, std::string const*> const streams[]
+            {
+                { "#~", &tables },
+                { "#Strings", &strings },
+                { "#US", &user_strings },
+                { "#GUID", &guids },
+                { "#Blob", &blobs },
+            };
+
+            append<uint16_t>(root, static_cast<uint16_t>(std::size(streams)));
+            size_t header_size = root.size();
+
+            for (auto&& [name, data] : streams)
+            {
+                header_size += 8 + (name.size() + 4) / 4 * 4;
+            }
+
+            uint32_t offset = static_cast<uint32_t>(header_size);
+
+            for (auto&& [name, data] : streams)
+            {
+                append<uint32_t>(root, offset);
+                append<uint32_t>(root, static_cast<uint32_t>(data->size()));
+                root += name;
+                root.push_back(0);
+                align(root, 4);
+                offset += static_cast<uint32_t>(data->size());
+            }
+
+            for (auto&& [name, data] : streams)
+            {
+                root += *data;
+            }
+
+            return root;
+        }
+
+    private:
+        uint32_t coded_size(coded_kind const& kind) const
+        {
+            uint32_t max_rows{};
+
+            for (auto&& table : kind.tables)
+            {
+                // The reader doesn't count DeclSecurity for HasCustomAttribute, and it's always empty here.
+                max_rows = (std::max)(max_rows, row_count(table));
+            }
+
+            return max_rows < (1u << (16 - kind.bits)) ? 2 : 4;
+        }
+
+        std::string m_strings;
+        std::string m_blobs;
+        std::string m_guids;
+        std::map<std::string, uint32_t> m_string_index;
+        std::map<std::string, uint32_t> m_blob_index;
+        std::map<uint32_t, std::vector<std::vector<uint32_t>>> m_tables;
+    };
+
+    // Wraps the metadata in the smallest PE32 image that winmd::reader::database accepts.
+    inline std::string make_image(std::string const& metadata)
+    {
+        using namespace winmd::impl;
+        uint32_t const section_rva = 0x2000;
+        uint32_t const section_offset = 0x200;
+        uint32_t const cli_size = sizeof(image_cor20_header);
+
+        image_dos_header dos{};
+        dos.e_signature = 0x5A4D;
+        dos.e_lfanew = sizeof(image_dos_header);
+
+        image_nt_headers32 nt{};
+        nt.Signature = 0x4550;
+        nt.FileHeader.Machine = 0x14c;
+        nt.FileHeader.NumberOfSections = 1;
+        nt.FileHeader.SizeOfOptionalHeader = sizeof(image_optional_header32);
+        nt.FileHeader.Characteristics = 0x2102;
+        nt.OptionalHeader.Magic = 0x10B;
+        nt.OptionalHeader.SectionAlignment = 0x2000;
+        nt.OptionalHeader.FileAlignment = 0x200;
+        nt.OptionalHeader.SizeOfHeaders = section_offset;
+        nt.OptionalHeader.SizeOfImage = section_rva + static_cast<uint32_t>((cli_size + metadata.size() + 0x1fff) / 0x2000 * 0x2000);
+        nt.OptionalHeader.NumberOfRvaAndSizes = 16;
+        nt.OptionalHeader.DataDirectory[14] = { section_rva, cli_size };
+
+        image_section_header section{};
+        std::memcpy(section.Name, ".text", 5);
+        section.Misc.VirtualSize = static_cast<uint32_t>(cli_size + metadata.size());
+        section.VirtualAddress = section_rva;
+        section.SizeOfRawData = static_cast<uint32_t>((cli_size + metadata.size() + 0x1ff) / 0x200 * 0x200);
+        section.PointerToRawData = section_offset;
+        section.Characteristics = 0x60000020;
+
+        image_cor20_header cli{};
+        cli.cb = cli_size;
+        cli.MajorRuntimeVersion = 2;
+        cli.MinorRuntimeVersion = 5;
+        cli.MetaData = { section_rva + cli_size, static_cast<uint32_t>(metadata.size()) };
+        cli.Flags = 1;
+
+        std::string image;
+        append(image, dos);
+        append(image, nt);
+        append(image, section);
+        image.resize(section_offset);
+        append(image, cli);
+        image += metadata;
+        image.resize(section_offset + section.SizeOfRawData);
+        return image;
+    }
+
+    enum class kind { token_type, enum_type, struct_type, delegate_type, generic_interface, interface_type, class_type, attribute_type, contract_type };
+
+    struct type_entry
+    {
+        std::string ns;
+        std::string name;
+        kind category;
+        uint32_t file;
+        uint32_t row; // TypeDef row within its own file
+    };
+
+    struct model
+    {
+        options const& opts;
+        std::vector<type_entry> types;
+        std::map<std::string, size_t> by_name;
+
+        explicit model(options const& o) : opts(o)
+        {
+            std::vector<uint32_t> rows(opts.files, 1); // Row 1 is always <Module>
+
+            auto add = [&](std::string ns, std::string name, kind category, uint32_t file)
+            {
+                auto full = ns + "." + name;
+                by_name[full] = types.size();
+                types.push_back({ std::move(ns), std::move(name), category, file, ++rows[file] });
+            };
+
+            add("Windows.Foundation", "EventRegistrationToken", kind::token_type, 0);
+            add("Synth", "SynthContract", kind::contract_type, 0);
+
+            for (uint32_t n = 0; n < opts.namespaces; ++n)
+            {
+                auto ns = namespace_name(n);
+                auto file = n % opts.files;
+
+                for (uint32_t i = 0; i < opts.attributes; ++i) add(ns, "Synth" + std::to_string(i) + "Attribute", kind::attribute_type, file);
+                for (uint32_t i = 0; i < opts.enums; ++i) add(ns, "E" + std::to_string(i), kind::enum_type, file);
+                for (uint32_t i = 0; i < opts.structs; ++i) add(ns, "S" + std::to_string(i), kind::struct_type, file);
+                for (uint32_t i = 0; i < opts.delegates; ++i) add(ns, "D" + std::to_string(i), kind::delegate_type, file);
+                for (uint32_t i = 0; i < opts.generics; ++i) add(ns, "IG" + std::to_string(i) + "`1", kind::generic_interface, file);
+                for (uint32_t i = 0; i < opts.interfaces; ++i) add(ns, "I" + std::to_string(i), kind::interface_type, file);
+
+                for (uint32_t i = 0; i < opts.classes; ++i)
+                {
+                    add(ns, "IC" + std::to_string(i), kind::interface_type, file);
+                    add(ns, "IC" + std::to_string(i) + "Statics", kind::interface_type, file);
+                    add(ns, "C" + std::to_string(i), kind::class_type, file);
+                }
+            }
+        }
+
+        static std::string namespace_name(uint32_t n)
+        {
+            return "Synth.N" + std::to_string(n);
+        }
+
+        type_entry const* find(std::string const& ns, std::string const& name) const
+        {
+            auto pos = by_name.find(ns + "." + name);
+            return pos == by_name.end() ? nullptr : &types[pos->second];
+        }
+    };
+
+    inline std::array<uint8_t, 16> make_guid(std::string_view const& name)
+    {
+        std::array<uint8_t, 16> result{};
+        uint64_t hash = 14695981039346656037ull;
+
+        for (size_t i = 0; i < 16; ++i)
+        {
+            for (auto c : name)
+            {
+                hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+            }
+
+            hash = (hash ^ i) * 1099511628211ull;
+            result[i] = static_cast<uint8_t>(hash >> 32);
+        }
+
+        return result;
+    }
+
+    struct file_writer
+    {
+        model const& m;
+        uint32_t file;
+        file_builder b;
+        std::map<std::string, uint32_t> type_refs;
+        std::map<std::string, uint32_t> assembly_refs;
+        std::map<std::string, uint32_t> member_refs;
+
+        file_writer(model const& model, uint32_t file_index) : m(model), file(file_index)
+        {
+        }
+
+        static std::string assembly_name(uint32_t file)
+        {
+            return "Synth.F" + std::to_string(file);
+        }
+
+        uint32_t assembly_ref(std::string const& name)
+        {
+            auto [pos, inserted] = assembly_refs.try_emplace(name, 0);
+
+            if (inserted)
+            {
+                pos->second = b.add_row(table_id::AssemblyRef, { 0xff, 0x200, 0, b.string(name), 0, 0 });
+            }
+
+            return pos->second;
+        }
+
+        uint32_t type_ref(std::string const& ns, std::string const& name, std::string const& assembly)
+        {
+            auto [pos, inserted] = type_refs.try_emplace(ns + "." + name, 0);
+
+            if (inserted)
+            {
+                auto scope = b.encode(coded_ResolutionScope, table_id::AssemblyRef, assembly_ref(assembly));
+                pos->second = b.add_row(table_id::TypeRef, { scope, b.string(name), b.string(ns) });
+            }
+
+            return pos->second;
+        }
+
+        uint32_t system_type(std::string const& name)
+        {
+            return b.encode(coded_TypeDefOrRef, table_id::TypeRef, type_ref("System", name, "mscorlib"));
+        }
+
+        uint32_t metadata_type(std::string const& name)
+        {
+            return type_ref("Windows.Foundation.Metadata", name, "Windows.Foundation.FoundationContract");
+        }
+
+        // The TypeDefOrRef coded index for a synthetic type, which is a TypeRef if it lives in another file.
+        uint32_t type(type_entry const& info)
+        {
+            if (info.file == file)
+            {
+                return b.encode(coded_TypeDefOrRef, table_id::TypeDef, info.row);
+            }
+
+            return b.encode(coded_TypeDefOrRef, table_id::TypeRef, type_ref(info.ns, info.name, assembly_name(info.file)));
+        }
+
+        void type_sig(std::string& sig, type_entry const& info)
+        {
+            bool const value_type = info.category == kind::enum_type || info.category == kind::struct_type || info.category == kind::token_type;
+            sig += static_cast<char>(value_type ? ElementType::ValueType : ElementType::Class);
+            compress_unsigned(sig, type(info));
+        }
+
+        void generic_sig(std::string& sig, type_entry const& generic, std::string const& arg)
+        {
+            sig += static_cast<char>(ElementType::GenericInst);
+            type_sig(sig, generic);
+            sig += static_cast<char>(1);
+            sig += arg;
+        }
+
+        std::string generic_arg(uint32_t n, uint32_t i)
+        {
+            std::string arg;
+
+            if (i % 2 == 0 || m.opts.structs == 0)
+            {
+                arg += static_cast<char>(ElementType::I4);
+            }
+            else
+            {
+                type_sig(arg, *m.find(model::namespace_name(n), "S0"));
+            }
+
+            return arg;
+        }
+
+        uint32_t method_sig(std::string const& ret, std::vector<std::string> const& params)
+        {
+            std::string sig;
+            sig += static_cast<char>(0x20); // HASTHIS
+            compress_unsigned(sig, static_cast<uint32_t>(params.size()));
+            sig += ret;
+
+            for (auto&& param : params)
+            {
+                sig += param;
+            }
+
+            return b.blob(sig);
+        }
+
+        static std::string element(ElementType type)
+        {
+            return std::string(1, static_cast<char>(type));
+        }
+
+        uint32_t attribute_ctor(std::string const& name, std::vector<std::string> const& params)
+        {
+            std::string key = name;
+
+            for (auto&& param : params)
+            {
+                key += ',' + param;
+            }
+
+            auto [pos, inserted] = member_refs.try_emplace(key, 0);
+
+            if (inserted)
+            {
+                auto parent = b.encode(coded_MemberRefParent, table_id::TypeRef, metadata_type(name));
+                pos->second = b.add_row(table_id::MemberRef, { parent, b.string(".ctor"), method_sig(element(ElementType::Void), params) });
+            }
+
+            return b.encode(coded_CustomAttributeType, table_id::MemberRef, pos->second);
+        }
+
+        std::string system_type_param()
+        {
+            std::string sig;
+            sig += static_cast<char>(ElementType::Class);
+            compress_unsigned(sig, system_type("Type"));
+            return sig;
+        }
+
+        void add_attribute(uint32_t parent_table, uint32_t parent_row, uint32_t ctor, std::string const& args)
+        {
+            std::string value;
+            append<uint16_t>(value, 1);
+            value += args;
+            append<uint16_t>(value, 0);
+            b.add_row(table_id::CustomAttribute, { b.encode(coded_HasCustomAttribute, parent_table, parent_row), ctor, b.blob(value) });
+        }
+
+        void add_guid(uint32_t row, std::string const& name)
+        {
+            auto params = std::vector<std::string>{ element(ElementType::U4), element(ElementType::U2), element(ElementType::U2) };
+            params.insert(params.end(), 8, element(ElementType::U1));
+            auto guid = make_guid(name);
+            std::string args(reinterpret_cast<char const*>(guid.data()), guid.size());
+            add_attribute(table_id::TypeDef, row, attribute_ctor("GuidAttribute", params), args);
+        }
+
+        void add_contract_version(uint32_t row, uint32_t version)
+        {
+            std::string args;
+            append_ser_string(args, "Synth.SynthContract");
+            append<uint32_t>(args, version << 16);
+            add_attribute(table_id::TypeDef, row, attribute_ctor("ContractVersionAttribute", { system_type_param(), element(ElementType::U4) }), args);
+        }
+
+        void add_exclusive_to(uint32_t row, std::string const& class_name)
+        {
+            std::string args;
+            append_ser_string(args, class_name);
+            add_attribute(table_id::TypeDef, row, attribute_ctor("ExclusiveToAttribute", { system_type_param() }), args);
+        }
+
+        uint32_t add_method(std::string const& name, uint16_t flags, std::string const& ret, std::vector<std::pair<std::string, std::string>> const& params, uint16_t impl_flags = 0)
+        {
+            std::vector<std::string> types;
+            auto first_param = b.row_count(table_id::Param) + 1;
+
+            for (uint16_t i = 0; i < params.size(); ++i)
+            {
+                types.push_back(params[i].second);
+                b.add_row(table_id::Param, { 1, static_cast<uint32_t>(i + 1), b.string(params[i].first) });
+            }
+
+            return b.add_row(table_id::MethodDef, { 0, impl_flags, flags, b.string(name), method_sig(ret, types), first_param });
+        }
+
+        uint32_t begin_type(type_entry const& info, uint32_t flags, uint32_t extends)
+        {
+            auto row = b.add_row(table_id::TypeDef, { flags, b.string(info.name), b.string(info.ns), extends, b.row_count(table_id::Field) + 1, b.row_count(table_id::MethodDef) + 1 });
+
+            if (row != info.row)
+            {
+                throw std::logic_error("TypeDef rows out of order");
+            }
+
+            return row;
+        }
+
+        static constexpr uint32_t tdPublic = 0x1, tdSequential = 0x8, tdInterface = 0x20, tdAbstract = 0x80, tdSealed = 0x100, tdWindowsRuntime = 0x4000;
+        static constexpr uint16_t mdAbstractVirtual = 0x05c6, mdSpecial = 0x0800;
+
+        void write_interface_members(uint32_t row, uint32_t n, uint32_t index, bool generic)
+        {
+            auto const& o = m.opts;
+            auto const ns = model::namespace_name(n);
+            auto i4 = element(ElementType::I4);
+            std::string t;
+
+            if (generic)
+            {
+                t += static_cast<char>(ElementType::Var);
+                t += static_cast<char>(0);
+                b.add_row(table_id::GenericParam, { 0, 0, b.encode(coded_TypeOrMethodDef, table_id::TypeDef, row), b.string("T") });
+                add_method("GetValue", mdAbstractVirtual, t, {});
+                add_method("SetValue", mdAbstractVirtual, element(ElementType::Void), { { "value", t } });
+                return;
+            }
+
+            for (uint32_t j = 0; j < o.methods; ++j)
+            {
+                std::vector<std::pair<std::string, std::string>> params{ { "first", i4 }, { "second", element(ElementType::String) } };
+
+                if (j % 3 == 1 && o.enums)
+                {
+                    std::string e;
+                    type_sig(e, *m.find(ns, "E" + std::to_string(j % o.enums)));
+                    params.push_back({ "third", e });
+                }
+
+                if (j % 3 == 2 && n > 0 && o.interfaces)
+                {
+                    std::string other;
+                    type_sig(other, *m.find(model::namespace_name(n - 1), "I" + std::to_string(j % o.interfaces)));
+                    params.push_back({ "other", other });
+                }
+
+                std::string ret = i4;
+
+                if (j % 2 == 1 && o.generics)
+                {
+                    ret.clear();
+                    generic_sig(ret, *m.find(ns, "IG" + std::to_string(j % o.generics) + "`1"), generic_arg(n, j));
+                }
+                else if (j % 4 == 2 && o.structs)
+                {
+                    ret.clear();
+                    type_sig(ret, *m.find(ns, "S" + std::to_string(j % o.structs)));
+                }
+
+                add_method("Method" + std::to_string(j), mdAbstractVirtual, ret, params);
+            }
+
+            std::vector<std::pair<uint32_t, uint32_t>> semantics;
+            auto first_property = b.row_count(table_id::Property) + 1;
+
+            for (uint32_t j = 0; j < o.properties; ++j)
+            {
+                auto name = "Property" + std::to_string(j);
+                auto getter = add_method("get_" + name, mdAbstractVirtual | mdSpecial, i4, {});
+                auto setter = add_method("put_" + name, mdAbstractVirtual | mdSpecial, element(ElementType::Void), { { "value", i4 } });
+                std::string sig{ static_cast<char>(0x28), 0 };
+                sig += i4;
+                auto property = b.add_row(table_id::Property, { 0, b.string(name), b.blob(sig) });
+                b.add_row(table_id::MethodSemantics, { 0x2, getter, b.encode(coded_HasSemantics, table_id::Property, property) });
+                b.add_row(table_id::MethodSemantics, { 0x1, setter, b.encode(coded_HasSemantics, table_id::Property, property) });
+            }
+
+            if (o.properties)
+            {
+                b.add_row(table_id::PropertyMap, { row, first_property });
+            }
+
+            if (o.delegates)
+            {
+                auto first_event = b.row_count(table_id::Event) + 1;
+                std::string token;
+                type_sig(token, *m.find("Windows.Foundation", "EventRegistrationToken"));
+
+                for (uint32_t j = 0; j < o.events; ++j)
+                {
+                    auto name = "Event" + std::to_string(j);
+                    auto const& handler = *m.find(ns, "D" + std::to_string((index + j) % o.delegates));
+                    std::string handler_sig;
+                    type_sig(handler_sig, handler);
+                    auto adder = add_method("add_" + name, mdAbstractVirtual | mdSpecial, token, { { "handler", handler_sig } });
+                    auto remover = add_method("remove_" + name, mdAbstractVirtual | mdSpecial, element(ElementType::Void), { { "token", token } });
+                    auto event = b.add_row(table_id::Event, { 0, b.string(name), type(handler) });
+                    b.add_row(table_id::MethodSemantics, { 0x8, adder, b.encode(coded_HasSemantics, table_id::Event, event) });
+                    b.add_row(table_id::MethodSemantics, { 0x10, remover, b.encode(coded_HasSemantics, table_id::Event, event) });
+                }
+
+                if (o.events)
+                {
+                    b.add_row(table_id::EventMap, { row, first_event });
+                }
+            }
+        }
+
+        void write_type(type_entry const& info, uint32_t n, uint32_t index)
+        {
+            auto const& o = m.opts;
+            auto const ns = model::namespace_name(n);
+            auto const full_name = info.ns + "." + info.name;
+
+            switch (info.category)
+            {
+            case kind::token_type:
+            {
+                begin_type(info, tdPublic | tdSequential | tdSealed | tdWindowsRuntime, system_type("ValueType"));
+                b.add_row(table_id::Field, { 0x6, b.string("Value"), b.blob(std::string{ 0x06, static_cast<char>(ElementType::I8) }) });
+                break;
+            }
+            case kind::contract_type:
+            {
+                auto row = begin_type(info, tdPublic | tdSequential | tdSealed | tdWindowsRuntime, system_type("ValueType"));
+                add_attribute(table_id::TypeDef, row, attribute_ctor("ApiContractAttribute", {}), {});
+                std::string args;
+                append<uint32_t>(args, 0x10000);
+                add_attribute(table_id::TypeDef, row, attribute_ctor("ContractVersionAttribute", { element(ElementType::U4) }), args);
+                break;
+            }
+            case kind::attribute_type:
+            {
+                auto row = begin_type(info, tdPublic | tdSealed | tdWindowsRuntime, system_type("Attribute"));
+                add_method(".ctor", 0x1886, element(ElementType::Void), { { "value", element(ElementType::I4) } }, 0x3);
+                (void)row;
+                break;
+            }
+            case kind::enum_type:
+            {
+                bool const flags = index == 0;
+                auto underlying = element(flags ? ElementType::U4 : ElementType::I4);
+                auto row = begin_type(info, tdPublic | tdSealed | tdWindowsRuntime, system_type("Enum"));
+                b.add_row(table_id::Field, { 0x0601, b.string("value__"), b.blob(std::string{ 0x06 } + underlying) });
+                std::string literal_sig{ 0x06 };
+                type_sig(literal_sig, info);
+
+                for (uint32_t value = 0; value < 4; ++value)
+                {
+                    auto field = b.add_row(table_id::Field, { 0x8056, b.string("Value" + std::to_string(value)), b.blob(literal_sig) });
+                    std::string constant;
+                    append<uint32_t>(constant, flags ? (value ? 1u << (value - 1) : 0) : value);
+                    b.add_row(table_id::Constant, { static_cast<uint32_t>(underlying[0]), b.encode(coded_HasConstant, table_id::Field, field), b.blob(constant) });
+                }
+
+                if (flags)
+                {
+                    auto ctor = b.encode(coded_CustomAttributeType, table_id::MemberRef, member_ref_system_flags());
+                    add_attribute(table_id::TypeDef, row, ctor, {});
+                }
+
+                add_contract_version(row, 1);
+                break;
+            }
+            case kind::struct_type:
+            {
+                auto row = begin_type(info, tdPublic | tdSequential | tdSealed | tdWindowsRuntime, system_type("ValueType"));
+                b.add_row(table_id::Field, { 0x6, b.string("Count"), b.blob(std::string{ 0x06, static_cast<char>(ElementType::I4) }) });
+                b.add_row(table_id::Field, { 0x6, b.string("Scale"), b.blob(std::string{ 0x06, static_cast<char>(ElementType::R8) }) });
+                b.add_row(table_id::Field, { 0x6, b.string("Name"), b.blob(std::string{ 0x06, static_cast<char>(ElementType::String) }) });
+
+                if (o.enums)
+                {
+                    std::string sig{ 0x06 };
+                    type_sig(sig, *m.find(ns, "E" + std::to_string(index % o.enums)));
+                    b.add_row(table_id::Field, { 0x6, b.string("Kind"), b.blob(sig) });
+                }
+
+                add_contract_version(row, 1);
+                break;
+            }
+            case kind::delegate_type:
+            {
+                auto row = begin_type(info, tdPublic | tdSealed | tdWindowsRuntime, system_type("MulticastDelegate"));
+                add_method(".ctor", 0x1886, element(ElementType::Void), { { "object", element(ElementType::Object) }, { "method", element(ElementType::I) } }, 0x3);
+                add_method("Invoke", 0x01c6, element(ElementType::Void), { { "sender", element(ElementType::Object) }, { "value", element(ElementType::I4) } }, 0x3);
+                add_guid(row, full_name);
+                add_contract_version(row, 1);
+                break;
+            }
+            case kind::generic_interface:
+            case kind::interface_type:
+            {
+                auto row = begin_type(info, tdPublic | tdInterface | tdAbstract | tdWindowsRuntime, 0);
+                write_interface_members(row, n, index, info.category == kind::generic_interface);
+                add_guid(row, full_name);
+                add_contract_version(row, 1 + index % 3);
+
+                if (info.name.rfind("IC", 0) == 0)
+                {
+                    auto class_name = info.name.substr(1);
+
+                    if (auto statics = class_name.find("Statics"); statics != std::string::npos)
+                    {
+                        class_name.resize(statics);
+                    }
+
+                    add_exclusive_to(row, ns + "." + class_name);
+                }
+                else if (o.attributes)
+                {
+                    auto const& attribute = *m.find(ns, "Synth" + std::to_string(index % o.attributes) + "Attribute");
+                    uint32_t ctor;
+
+                    if (attribute.file == file)
+                    {
+                        ctor = b.encode(coded_CustomAttributeType, table_id::MethodDef, attribute_ctor_row(attribute));
+                    }
+                    else
+                    {
+                        auto key = attribute.ns + "." + attribute.name;
+                        auto [pos, inserted] = member_refs.try_emplace(key, 0);
+
+                        if (inserted)
+                        {
+                            auto parent = b.encode(coded_MemberRefParent, table_id::TypeRef, type_ref(attribute.ns, attribute.name, assembly_name(attribute.file)));
+                            pos->second = b.add_row(table_id::MemberRef, { parent, b.string(".ctor"), method_sig(element(ElementType::Void), { element(ElementType::I4) }) });
+                        }
+
+                        ctor = b.encode(coded_CustomAttributeType, table_id::MemberRef, pos->second);
+                    }
+
+                    std::string args;
+                    append<int32_t>(args, static_cast<int32_t>(index));
+                    add_attribute(table_id::TypeDef, row, ctor, args);
+                }
+
+                break;
+            }
+            case kind::class_type:
+            {
+                auto row = begin_type(info, tdPublic | tdSealed | tdWindowsRuntime, system_type("Object"));
+                auto default_interface = b.add_row(table_id::InterfaceImpl, { row, type(*m.find(ns, "I" + info.name)) });
+                add_attribute(table_id::InterfaceImpl, default_interface, attribute_ctor("DefaultAttribute", {}), {});
+
+                if (o.interfaces)
+                {
+                    b.add_row(table_id::InterfaceImpl, { row, type(*m.find(ns, "I" + std::to_string(index % o.interfaces))) });
+                }
+
+                if (o.generics)
+                {
+                    auto spec = std::string{};
+                    generic_sig(spec, *m.find(ns, "IG0`1"), generic_arg(n, index));
+                    auto type_spec = b.add_row(table_id::TypeSpec, { b.blob(spec) });
+                    b.add_row(table_id::InterfaceImpl, { row, b.encode(coded_TypeDefOrRef, table_id::TypeSpec, type_spec) });
+                }
+
+                std::string args;
+                append<uint32_t>(args, 0x10000);
+                add_attribute(table_id::TypeDef, row, attribute_ctor("ActivatableAttribute", { element(ElementType::U4) }), args);
+                args.clear();
+                append_ser_string(args, ns + ".I" + info.name + "Statics");
+                append<uint32_t>(args, 0x10000);
+                add_attribute(table_id::TypeDef, row, attribute_ctor("StaticAttribute", { system_type_param(), element(ElementType::U4) }), args);
+                add_contract_version(row, 1);
+                break;
+            }
+            }
+        }
+
+        uint32_t member_ref_system_flags()
+        {
+            auto [pos, inserted] = member_refs.try_emplace("System.FlagsAttribute", 0);
+
+            if (inserted)
+            {
+                auto parent = b.encode(coded_MemberRefParent, table_id::TypeRef, type_ref("System", "FlagsAttribute", "mscorlib"));
+                pos->second = b.add_row(table_id::MemberRef, { parent, b.string(".ctor"), method_sig(element(ElementType::Void), {}) });
+            }
+
+            return pos->second;
+        }
+
+        // Attribute types are written before anything that uses them, and have a single constructor.
+        std::map<std::string, uint32_t> attribute_ctors;
+
+        uint32_t attribute_ctor_row(type_entry const& attribute)
+        {
+            return attribute_ctors.at(attribute.name + "@" + attribute.ns);
+        }
+
+        std::string write()
+        {
+            auto const assembly = assembly_name(file);
+            b.add_row(table_id::Module, { 0, b.string(assembly + ".winmd"), b.guid(make_guid(assembly)), 0, 0 });
+            b.add_row(table_id::TypeDef, { 0, b.string("<Module>"), 0, 0, 1, 1 });
+            std::map<std::string, uint32_t> counters;
+
+            for (auto&& info : m.types)
+            {
+                if (info.file != file)
+                {
+                    continue;
+                }
+
+                uint32_t n = 0;
+
+                if (info.ns.rfind("Synth.N", 0) == 0)
+                {
+                    n = static_cast<uint32_t>(std::stoul(info.ns.substr(std::string_view{ "Synth.N" }.size())));
+                }
+
+                auto& index = counters[info.ns + "/" + std::to_string(static_cast<int>(info.category))];
+
+                if (info.category == kind::attribute_type)
+                {
+                    attribute_ctors[info.name + "@" + info.ns] = b.row_count(table_id::MethodDef) + 1;
+                }
+
+                write_type(info, n, index++);
+            }
+
+            b.add_row(table_id::Assembly, { 0x8004, 0xff, 0x200, 0, b.string(assembly), 0 });
+            b.sort(table_id::CustomAttribute, 0);
+            b.sort(table_id::Constant, 1);
+            b.sort(table_id::MethodSemantics, 2);
+            b.sort(table_id::GenericParam, 2);
+            return make_image(b.metadata());
+        }
+    };
+
+    // Writes synthetic Windows Runtime metadata files with a configurable number of types. The
+    // files are meant for exercising and benchmarking cppwinrt, so they only need to be accepted
+    // by winmd::reader and to cover the shapes of metadata that the code writers care about.
+    // Returns the number of types written, not counting each file's <Module> type.
+    inline size_t write_files(options o, std::filesystem::path const& folder)
+    {
+        o.files = (std::max)(1u, (std::min)(o.files, o.namespaces));
+        model const m{ o };
+        std::filesystem::create_directories(folder);
+
+        for (uint32_t file = 0; file < o.files; ++file)
+        {
+            file_writer writer{ m, file };
+            auto const image = writer.write();
+            std::ofstream stream;
+            stream.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+            stream.open(folder / (file_writer::assembly_name(file) + ".winmd"), std::ios::out | std::ios::binary);
+            stream.write(image.data(), image.size());
+        }
+
+        return m.types.size();
+    }
+}
@@ -2195,7 +2195,7 @@ struct WINRT_IMPL_EMPTY_BASES produce_dispatch_to_overridable<T, D, %>
 
     static void write_class_override_usings(writer& w, get_interfaces_t const& required_interfaces)
     {
-        std::map<std::string_view, std::set<std::string>> method_usage;
+        std::map<std::string_view, std::set<std::string_view>> method_usage;
 
         for (auto&& [interface_name, info] : required_interfaces)
         {
@@ -2288,9 +2288,9 @@ struct WINRT_IMPL_EMPTY_BASES produce_dispatch_to_overridable<T, D, %>
     static void write_interface_usings(writer& w, TypeDef const& type)
     {
         auto type_name = type.TypeName();
-        auto interfaces_plus_self = get_interfaces(w, type);
+        get_interfaces_t interfaces_plus_self = get_interfaces(w, type);
         interfaces_plus_self.emplace_back(type_name, interface_info{ type });
-        std::map<std::string_view, std::set<std::string>> method_usage;
+        std::map<std::string_view, std::set<std::string_view>> method_usage;
 
         for (auto&& [interface_name, info] : interfaces_plus_self)
         {
@@ -2322,7 +2322,7 @@ struct WINRT_IMPL_EMPTY_BASES produce_dispatch_to_overridable<T, D, %>
         auto type_name = type.TypeName();
         auto default_interface = get_default_interface(type);
         auto default_interface_name = w.write_temp("%", default_interface);
-        std::map<std::string_view, std::set<std::string>> method_usage;
+        std::map<std::string_view, std::set<std::string_view>> method_usage;
 
         for (auto&& [interface_name, info] : get_interfaces(w, type))
         {
@@ -4,7 +4,7 @@ namespace cppwinrt
 {
     static void write_component_override_defaults(writer& w, TypeDef const& type)
     {
-        std::vector<std::string> interfaces;
+        std::vector<std::string_view> interfaces;
 
         for (auto&& base : get_bases(type))
         {
@@ -2,6 +2,17 @@
 
 namespace cppwinrt
 {
+    // Flushes the folders recorded by -durable, so that the renames that replaced their files are
+    // durable too. The files themselves were flushed before they were renamed. Doing this once at
+    // the end avoids stalling each header write on the disk.
+    static void sync_written_files()
+    {
+        for (auto&& folder : written_folders::take())
+        {
+            sync_path(folder, true);
+        }
+    }
+
     static void write_base_h()
     {
         writer w;
@@ -65,10 +76,25 @@ namespace cppwinrt
         w.flush_to_file(settings.output_folder + "winrt/fast_forward.h");
     }
 
-    static void write_namespace_0_h(std::string_view const& ns, cache::namespace_members const& members)
+    // Namespaces that a header includes or forward declares types from, as recorded by the
+    // incremental manifest.
+    static std::vector<std::string_view> get_depends_namespaces(writer const& w)
+    {
+        std::vector<std::string_view> result;
+
+        for (auto&& depends : w.depends)
+        {
+            result.push_back(depends.first);
+        }
+
+        return result;
+    }
+
+    static auto write_namespace_0_h(std::string_view const& ns, cache::namespace_members const& members)
     {
         writer w;
         w.type_namespace = ns;
+        w.memory_budget(settings.buffer_size);
 
         {
             auto wrap_type = wrap_type_namespace(w, ns);
@@ -119,12 +145,14 @@ namespace cppwinrt
         }
 
         w.save_header('0');
+        return get_depends_namespaces(w);
     }
 
-    static void write_namespace_1_h(std::string_view const& ns, cache::namespace_members const& members)
+    static auto write_namespace_1_h(std::string_view const& ns, cache::namespace_members const& members)
     {
         writer w;
         w.type_namespace = ns;
+        w.memory_budget(settings.buffer_size);
 
         {
             auto wrap_type = wrap_type_namespace(w, ns);
@@ -144,12 +172,14 @@ namespace cppwinrt
 
         w.write_depends(w.type_namespace, '0');
         w.save_header('1');
+        return get_depends_namespaces(w);
     }
 
-    static void write_namespace_2_h(std::string_view const& ns, cache::namespace_members const& members)
+    static auto write_namespace_2_h(std::string_view const& ns, cache::namespace_members const& members)
     {
         writer w;
         w.type_namespace = ns;
+        w.memory_budget(settings.buffer_size);
 
         bool promote;
         {
@@ -174,12 +204,14 @@ namespace cppwinrt
 
         w.write_depends(w.type_namespace, '1');
         w.save_header('2');
+        return get_depends_namespaces(w);
     }
 
-    static void write_namespace_h(cache const& c, std::string_view const& ns, cache::namespace_members const& members)
+    static auto write_namespace_h(cache const& c, std::string_view const& ns, cache::namespace_members const& members)
     {
         writer w;
         w.type_namespace = ns;
+        w.memory_budget(settings.buffer_size);
 
         {
             auto wrap_impl = wrap_impl_namespace(w);
@@ -229,6 +261,7 @@ namespace cppwinrt
 
         w.write_depends(w.type_namespace, '2');
         w.save_header();
+        return get_depends_namespaces(w);
     }
 
     static void write_module_g_cpp(std::vector<TypeDef> const& classes)
@@ -119,7 +119,7 @@ namespace cppwinrt
     private:
 
         MethodDef m_method;
-        MethodDefSig m_signature;
+        MethodDefSig const& m_signature;
         std::vector<std::pair<Param, ParamSig const*>> m_params;
         Param m_return;
     };
@@ -466,7 +466,66 @@ namespace cppwinrt
         return current_contract;
     }
 
-    static contract_history get_contract_history(TypeDef const& type)
+    // Analyses of a type that many writers need are computed once and then shared by every thread.
+    // The first result to be stored wins, which is fine since the analyses are deterministic.
+    template <typename T, typename Key = TypeDef>
+    struct type_analysis_cache
+    {
+        template <typename F>
+        T const& get(Key const& type, F&& compute)
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                auto found = m_results.find(type);
+
+                if (found != m_results.end())
+                {
+                    return found->second;
+                }
+            }
+
+            auto result = compute();
+            std::lock_guard lock(m_mutex);
+            return m_results.try_emplace(type, std::move(result)).first->second;
+        }
+
+    private:
+
+        std::mutex m_mutex;
+        std::map<Key, T> m_results;
+    };
+
+    // A result built with a scratch writer, along with the types it added as dependencies so that
+    // they can be added to each writer that uses the result.
+    template <typename T>
+    struct writer_analysis
+    {
+        T value;
+        std::vector<TypeDef> depends;
+    };
+
+    template <typename T, typename F>
+    static writer_analysis<T> analyze_with_writer(F&& compute)
+    {
+        writer scratch;
+        writer_analysis<T> result{ compute(scratch), {} };
+
+        for (auto&& [ns, types] : scratch.depends)
+        {
+            result.depends.insert(result.depends.end(), types.begin(), types.end());
+        }
+
+        return result;
+    }
+
+    // Writer state that changes how type names are written. Analyses are only shared when it's
+    // all at its defaults, which it is for nearly every caller.
+    static bool has_default_naming(writer const& w)
+    {
+        return !w.abi_types && !w.consume_types && !w.async_types && !w.delegate_types && w.generic_param_stack.empty();
+    }
+
+    static contract_history get_contract_history_uncached(TypeDef const& type)
     {
         contract_history result{};
         for (auto&& attribute : type.CustomAttribute())
@@ -523,6 +582,12 @@ namespace cppwinrt
         return result;
     }
 
+    static contract_history get_contract_history(TypeDef const& type)
+    {
+        static type_analysis_cache<contract_history> analyses;
+        return analyses.get(type, [&] { return get_contract_history_uncached(type); });
+    }
+
     struct interface_info
     {
         TypeDef type;
@@ -540,13 +605,101 @@ namespace cppwinrt
         std::vector<std::vector<std::string>> generic_param_stack{};
     };
 
-    using get_interfaces_t = std::vector<std::pair<std::string, interface_info>>;
+    // Generated type names are interned for the rest of the run, so that each distinct name is only
+    // allocated once and interned names can be compared by address.
+    static std::string_view intern_name(std::string_view const& name)
+    {
+        static std::mutex mutex;
+        static std::set<std::string, std::less<>> names;
+        std::lock_guard lock(mutex);
+        auto found = names.find(name);
+
+        if (found == names.end())
+        {
+            found = names.emplace(name).first;
+        }
+
+        return *found;
+    }
+
+    static bool is_closed_generic(GenericTypeInstSig const& signature)
+    {
+        for (auto&& arg : signature.GenericArgs())
+        {
+            auto const& type = arg.Type();
+
+            if (std::holds_alternative<GenericTypeIndex>(type) || std::holds_alternative<GenericMethodTypeIndex>(type))
+            {
+                return false;
+            }
+
+            if (auto generic = std::get_if<GenericTypeInstSig>(&type); generic && !is_closed_generic(*generic))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // The interned name of an interface, as written by w.write("%", type). Names that don't depend on
+    // the writer's generic parameters are only written once per TypeDef or TypeSpec.
+    static std::string_view get_interned_name(writer& w, coded_index<TypeDefOrRef> const& type)
+    {
+        switch (type.type())
+        {
+        case TypeDefOrRef::TypeDef:
+        case TypeDefOrRef::TypeRef:
+        {
+            if (type.type() == TypeDefOrRef::TypeRef && type_name(type.TypeRef()) == "System.Guid")
+            {
+                return intern_name("winrt::guid");
+            }
+
+            auto definition = find_required(type);
+            w.add_depends(definition);
+            static type_analysis_cache<std::string_view> analyses;
+
+            return analyses.get(definition, [&]
+            {
+                writer scratch;
+                return intern_name(scratch.write_temp("%", definition));
+            });
+        }
+        default:
+        {
+            auto const spec = type.TypeSpec();
+
+            if (w.abi_types || w.consume_types || !is_closed_generic(spec.Signature().GenericTypeInst()))
+            {
+                return intern_name(w.write_temp("%", type));
+            }
+
+            static type_analysis_cache<writer_analysis<std::string_view>, TypeSpec> analyses;
+
+            auto const& result = analyses.get(spec, [&]
+            {
+                return analyze_with_writer<std::string_view>([&](writer& scratch) { return intern_name(scratch.write_temp("%", type)); });
+            });
+
+            for (auto&& depends : result.depends)
+            {
+                w.add_depends(depends);
+            }
+
+            return result.value;
+        }
+        }
+    }
+
+    // The names in an interface set are always interned.
+    using get_interfaces_t = std::vector<std::pair<std::string_view, interface_info>>;
 
     static interface_info* find(get_interfaces_t& interfaces, std::string_view const& name)
     {
         auto pair = std::find_if(interfaces.begin(), interfaces.end(), [&](auto&& pair)
         {
-            return pair.first == name;
+            return pair.first.data() == name.data();
         });
 
         if (pair == interfaces.end())
@@ -575,7 +728,7 @@ namespace cppwinrt
         {
             interface_info info;
             auto type = impl.Interface();
-            auto name = w.write_temp("%", type);
+            auto name = get_interned_name(w, type);
             info.is_default = has_attribute(impl, "Windows.Foundation.Metadata", "DefaultAttribute");
             info.defaulted = !base && (defaulted || info.is_default);
 
@@ -616,7 +769,7 @@ namespace cppwinrt
                 }
                 case TypeDefOrRef::TypeSpec:
                 {
-                    auto type_signature = type.TypeSpec().Signature();
+                    auto const& type_signature = type.TypeSpec().Signature();
 
                     std::vector<std::string> names;
 
@@ -641,7 +794,7 @@ namespace cppwinrt
         }
     };
 
-    static auto get_interfaces(writer& w, TypeDef const& type)
+    static auto get_interfaces_uncached(writer& w, TypeDef const& type)
     {
         w.abi_types = false;
         get_interfaces_t result;
@@ -734,6 +887,64 @@ namespace cppwinrt
         return result;
     }
 
+    // The result of get_interfaces refers to the shared analysis when the writer's naming allows it
+    // to be cached, and otherwise holds interfaces computed for the call. Callers that change the
+    // interfaces take a copy of their own.
+    struct interfaces_result
+    {
+        get_interfaces_t owned;
+        get_interfaces_t const* cached{};
+
+        get_interfaces_t const& get() const noexcept
+        {
+            return cached ? *cached : owned;
+        }
+
+        operator get_interfaces_t const&() const noexcept
+        {
+            return get();
+        }
+
+        auto begin() const noexcept
+        {
+            return get().begin();
+        }
+
+        auto end() const noexcept
+        {
+            return get().end();
+        }
+
+        bool empty() const noexcept
+        {
+            return get().empty();
+        }
+    };
+
+    static interfaces_result get_interfaces(writer& w, TypeDef const& type)
+    {
+        w.abi_types = false;
+
+        if (!has_default_naming(w))
+        {
+            return { get_interfaces_uncached(w, type) };
+        }
+
+        static type_analysis_cache<writer_analysis<get_interfaces_t>> analyses;
+
+        auto const& result = analyses.get(type, [&]
+        {
+            return analyze_with_writer<get_interfaces_t>([&](writer& scratch) { return get_interfaces_uncached(scratch, type); });
+        });
+
+        for (auto&& depends : result.depends)
+        {
+            w.add_depends(depends);
+        }
+
+        return { {}, &result.value };
+    }
+
     static bool implements_interface(TypeDef const& type, std::string_view const& name)
     {
         for (auto&& impl : type.InterfaceImpl())
@@ -813,7 +1024,7 @@ namespace cppwinrt
         bool visible{};
     };
 
-    static auto get_factories(writer& w, TypeDef const& type)
+    static auto get_factories_uncached(writer& w, TypeDef const& type)
     {
         auto get_system_type = [&](auto&& signature) -> TypeDef
         {
@@ -884,6 +1095,28 @@ namespace cppwinrt
         return result;
     }
 
+    static std::map<std::string, factory_info> get_factories(writer& w, TypeDef const& type)
+    {
+        if (!has_default_naming(w))
+        {
+            return get_factories_uncached(w, type);
+        }
+
+        static type_analysis_cache<writer_analysis<std::map<std::string, factory_info>>> analyses;
+
+        auto const& result = analyses.get(type, [&]
+        {
+            return analyze_with_writer<std::map<std::string, factory_info>>([&](writer& scratch) { return get_factories_uncached(scratch, type); });
+        });
+
+        for (auto&& depends : result.depends)
+        {
+            w.add_depends(depends);
+        }
+
+        return result.value;
+    }
+
     enum class param_category
     {
         generic_type,
@@ -1009,7 +1242,7 @@ namespace cppwinrt
 
     static std::string get_field_abi(writer& w, Field const& field)
     {
-        auto signature = field.Signature();
+        auto const& signature = field.Signature();
         auto const& type = signature.Type();
         std::string name = w.write_temp("%", type);
 
@@ -1112,6 +1345,41 @@ namespace cppwinrt
             !members.delegates.empty();
     }
 
+    // Rough estimate of the work needed to write each of a namespace's headers, indexed by header:
+    // the three impl headers followed by the namespace header. Only the relative sizes matter, as
+    // these are used to start the most expensive headers first.
+    static std::array<size_t, 4> get_namespace_costs(cache::namespace_members const& members)
+    {
+        auto sum = [](auto const& types, auto&& cost)
+        {
+            size_t result{};
+
+            for (auto&& type : types)
+            {
+                result += cost(type);
+            }
+
+            return result;
+        };
+
+        auto const enums = sum(members.enums, [](TypeDef const& type) { return 1 + size(type.FieldList()); });
+        auto const structs = sum(members.structs, [](TypeDef const& type) { return 1 + size(type.FieldList()); });
+        auto const delegates = sum(members.delegates, [](TypeDef const& type) { return 2 + size(type.MethodList()); });
+        auto const interfaces = sum(members.interfaces, [](TypeDef const& type) { return 1 + size(type.MethodList()); });
+
+        // Class members are projected from all of the class's interfaces, whose method counts are
+        // not known without resolving them, so assume a handful of methods per interface.
+        auto const classes = sum(members.classes, [](TypeDef const& type) { return 1 + 4 * size(type.InterfaceImpl()); });
+
+        return
+        {
+            enums + structs + delegates + 3 * interfaces + members.classes.size(),
+            interfaces,
+            structs + delegates + 2 * classes,
+            enums + 2 * delegates + 5 * interfaces + 3 * classes,
+        };
+    }
+
     static bool can_produce(TypeDef const& type, cache const& c)
     {
         auto attribute = get_attribute(type, "Windows.Foundation.Metadata", "ExclusiveToAttribute");
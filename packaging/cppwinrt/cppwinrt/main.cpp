@@ -7,11 +7,14 @@
 #include "code_writers.h"
 #include "component_writers.h"
 #include "file_writers.h"
+#include "manifest.h"
+#include "reachable_types.h"
 #include "type_writers.h"
 
 namespace cppwinrt
 {
     settings_type settings;
+    profiler profile;
 
     struct usage_exception {};
 
@@ -28,6 +31,8 @@ namespace cppwinrt
         { "pch", 0, 1, "<name>", "Specify name of precompiled header file (defaults to pch.h; use '.' to disable)" },
         { "include", 0, option::no_max, "<prefix>", "One or more prefixes to include in input" },
         { "exclude", 0, option::no_max, "<prefix>", "One or more prefixes to exclude from input" },
+        { "root", 0, option::no_max, "<name>", "Project only these types, or the types of these members, and the types they need" },
+        { "scan", 0, option::no_max, "<path>", "Project only the types these C++ sources name with winrt::, and the types they need" },
         { "base", 0, 0, {}, "Generate base.h unconditionally" },
         { "optimize", 0, 0, {}, "Generate component projection with unified construction support" },
         { "help", 0, option::no_max, {}, "Show detailed help with examples" },
@@ -38,6 +43,12 @@ namespace cppwinrt
         { "brackets", 0, 0 }, // Use angle brackets for #includes (defaults to quotes)
         { "fastabi", 0, 0 }, // Enable support for the Fast ABI
         { "ignore_velocity", 0, 0 }, // Ignore feature staging metadata and always include implementations
+        { "incremental", 0, 0, {}, "Only regenerate namespaces whose metadata has changed since the last run" },
+        { "jobs", 0, 1, "<count>", "Limit number of concurrent worker threads (defaults to processor count)" },
+        { "buffer", 0, 1, "<kb>", "Limit memory used to buffer each header, streaming larger ones to disk" },
+        { "durable", 0, 0, {}, "Flush generated files to disk before exiting" },
+        { "cache", 0, 1, "<path>", "Save metadata indexes to a file and reuse them while the inputs are unchanged" },
+        { "profile", 0, 1, "<path>", "Write a Chrome trace of each phase and list the slowest namespaces" },
         { "synchronous", 0, 0 }, // Instructs cppwinrt to run on a single thread to avoid file system issues in batch builds
     };
 
@@ -81,9 +92,32 @@ R"(  local               Local ^%WinDir^%\System32\WinMetadata folder
         w.write(format, CPPWINRT_VERSION_STRING, bind_each(printOption, options));
     }
 
+    static uint32_t get_positive_value(reader const& args, std::string_view const& name)
+    {
+        if (!args.exists(name))
+        {
+            return 0;
+        }
+
+        auto value = args.value(name);
+        char* end{};
+        auto result = strtoul(value.c_str(), &end, 10);
+
+        if (value.empty() || *end || result == 0 || result > UINT32_MAX)
+        {
+            throw_invalid("Option '", name, "' requires a positive number");
+        }
+
+        return static_cast<uint32_t>(result);
+    }
+
     static void process_args(reader const& args)
     {
         settings.verbose = args.exists("verbose");
+        settings.incremental = args.exists("incremental");
+        settings.durable = args.exists("durable");
+        settings.cache_file = args.value("cache");
+        settings.profile_file = args.value("profile");
         settings.fastabi = args.exists("fastabi");
 
         settings.input = args.files("input", database::is_database);
@@ -92,6 +126,9 @@ R"(  local               Local ^%WinDir^%\System32\WinMetadata folder
         settings.component = args.exists("component");
         settings.base = args.exists("base");
 
+        settings.jobs = get_positive_value(args, "jobs");
+        settings.buffer_size = get_positive_value(args, "buffer") * size_t{ 1024 };
+
         settings.license = args.exists("license");
         settings.brackets = args.exists("brackets");
 
@@ -115,6 +152,13 @@ R"(  local               Local ^%WinDir^%\System32\WinMetadata folder
             settings.exclude.insert(exclude);
         }
 
+        for (auto&& root : args.values("root"))
+        {
+            settings.roots.insert(root);
+        }
+
+        settings.scan = args.files("scan", is_source_file);
+
         if (settings.license)
         {
             std::string license_arg = args.value("license");
@@ -232,6 +276,58 @@ R"(  local               Local ^%WinDir^%\System32\WinMetadata folder
         settings.component_filter = { settings.include.empty() ? include : settings.include, settings.exclude };
     }
 
+    // With -root or -scan, only the types reachable from the roots are projected. Component
+    // classes are roots as well, so that their templates are still generated.
+    static void remove_unused_types(cache& c)
+    {
+        if (settings.roots.empty() && settings.scan.empty())
+        {
+            return;
+        }
+
+        reachable_types reachable{ c };
+
+        for (auto&& root : settings.roots)
+        {
+            auto type = find_root_type(c, get_metadata_name(root));
+
+            if (!type)
+            {
+                throw_invalid("Root '", root, "' does not name a type or a member of one");
+            }
+
+            reachable.add(type);
+        }
+
+        std::set<std::string> names;
+
+        for (auto&& file : settings.scan)
+        {
+            scan_source_names(file, names);
+        }
+
+        for (auto&& name : names)
+        {
+            reachable.add(find_root_type(c, name));
+        }
+
+        if (settings.component)
+        {
+            for (auto&& [ns, members] : c.namespaces())
+            {
+                for (auto&& type : members.classes)
+                {
+                    if (settings.component_filter.includes(type))
+                    {
+                        reachable.add(type);
+                    }
+                }
+            }
+        }
+
+        remove_unreachable_types(c, reachable.get());
+    }
+
     static void build_fastabi_cache(cache const& c)
     {
         if (!settings.fastabi)
@@ -281,6 +377,79 @@ R"(  local               Local ^%WinDir^%\System32\WinMetadata folder
         c.remove_type("Windows.Foundation.Numerics", "Vector4");
     }
 
+    static bool has_namespace_headers(std::string_view const& ns)
+    {
+        auto filename = settings.output_folder + "winrt/impl/";
+        filename += ns;
+
+        for (auto impl : { ".0.h", ".1.h", ".2.h" })
+        {
+            if (!exists(filename + impl))
+            {
+                return false;
+            }
+        }
+
+        return exists(settings.output_folder + "winrt/" + std::string{ ns } + ".h");
+    }
+
+    // The whole projection is current if neither the options nor any of the input files have
+    // changed and all of the headers written last time still exist, in which case the metadata
+    // doesn't even need to be loaded. Component files are never skipped this way.
+    static bool is_projection_current(manifest const& previous, manifest const& current)
+    {
+        if (settings.component || previous.settings != current.settings || previous.files != current.files)
+        {
+            return false;
+        }
+
+        for (auto&& name : previous.outputs)
+        {
+            if (!exists(settings.output_folder + name))
+            {
+                return false;
+            }
+        }
+
+        for (auto&& [ns, entry] : previous.namespaces)
+        {
+            if (entry.projected && !has_namespace_headers(ns))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Writes the trace for -profile and lists the namespaces whose headers took longest to write,
+    // adding up the time spent on each of their headers.
+    static void write_profile(writer& w, std::map<std::string_view, profiler::clock::duration> const& namespaces)
+    {
+        if (!profile.enabled())
+        {
+            return;
+        }
+
+        profile.write_trace(settings.profile_file);
+
+        std::vector<std::pair<std::string_view, profiler::clock::duration>> slowest(namespaces.begin(), namespaces.end());
+        auto const count = (std::min)(slowest.size(), size_t{ 10 });
+
+        std::partial_sort(slowest.begin(), slowest.begin() + count, slowest.end(), [](auto&& left, auto&& right)
+        {
+            return left.second > right.second;
+        });
+
+        for (size_t index = 0; index < count; ++index)
+        {
+            auto const& [ns, elapsed] = slowest[index];
+            w.write_printf(" slow:  %8.2fms  %.*s\n", std::chrono::duration<double, std::milli>(elapsed).count(), static_cast<int>(ns.size()), ns.data());
+        }
+
+        w.write(" trace: %\n", settings.profile_file);
+    }
+
     static int run(int const argc, char** argv)
     {
         int result{};
@@ -298,11 +467,118 @@ R"(  local               Local ^%WinDir^%\System32\WinMetadata folder
             }
 
             process_args(args);
-            cache c{ get_files_to_cache(), [](TypeDef const& type) { return type.Flags().WindowsRuntime(); } };
-            remove_foundation_types(c);
-            build_filters(c);
+
+            if (!settings.profile_file.empty())
+            {
+                profile.enable(start);
+                profile.add("phase", "arguments", start, profiler::clock::now());
+            }
+
+            manifest previous;
+            manifest current;
+            std::vector<uint64_t> file_hashes;
+            auto const manifest_path = settings.output_folder + "cppwinrt.manifest";
+
+            if (settings.incremental)
+            {
+                auto const manifest_start = profiler::clock::now();
+                current.settings = get_settings_fingerprint(args, options);
+
+                // Moving a file between -input and -reference changes what is projected, so each
+                // file is recorded along with the option that named it.
+                for (auto&& [role, files] : { std::pair{ "input", &settings.input }, std::pair{ "reference", &settings.reference }, std::pair{ "scan", &settings.scan } })
+                {
+                    for (auto&& file : *files)
+                    {
+                        auto const fingerprint = get_file_fingerprint(file);
+                        current.files[w.write_temp("% %", role, file)] = fingerprint;
+
+                        // The cache identifies its files by these same fingerprints, in the order
+                        // of get_files_to_cache, rather than reading them again.
+                        if (files != &settings.scan)
+                        {
+                            file_hashes.push_back(fingerprint);
+                        }
+                    }
+                }
+
+                previous = manifest::load(manifest_path);
+                auto const projection_current = is_projection_current(previous, current);
+                profile.add("phase", "manifest", manifest_start, profiler::clock::now());
+
+                if (projection_current)
+                {
+                    if (settings.verbose)
+                    {
+                        w.write(" time:  %ms (up to date)\n", get_elapsed_time(start));
+                    }
+
+                    write_profile(w, {});
+                    w.flush_to_console();
+                    return result;
+                }
+            }
+
+            // A projection filtered by -include or limited to the types reachable from -root and -scan
+            // only reads a small part of the metadata, so it is paged in on demand, whereas a full
+            // projection reads nearly all of it and is faster with expanded tables.
+            cache_options load_options;
+            load_options.jobs = args.exists("synchronous") ? 1 : settings.jobs;
+            load_options.file_hashes = std::move(file_hashes);
+
+            if (settings.include.empty() && settings.roots.empty() && settings.scan.empty())
+            {
+                load_options.layout = table_layout::expanded;
+            }
+            else
+            {
+                load_options.population = file_population::lazy;
+            }
+
+            auto const cache_start = profiler::clock::now();
+            cache c{ get_files_to_cache(), [](TypeDef const& type) { return type.Flags().WindowsRuntime(); }, load_options, settings.cache_file };
+            profile.add("phase", "cache", cache_start, profiler::clock::now());
+
+            {
+                profiler::scope scope{ profile, "phase", "filters" };
+                remove_foundation_types(c);
+                build_filters(c);
+            }
+
+            {
+                profiler::scope scope{ profile, "phase", "reachable types" };
+                remove_unused_types(c);
+            }
+
             settings.base = settings.base || (!settings.component && settings.projection_filter.empty());
-            build_fastabi_cache(c);
+
+            {
+                profiler::scope scope{ profile, "phase", "fastabi cache" };
+                build_fastabi_cache(c);
+            }
+
+            std::map<std::string_view, uint64_t> fingerprints;
+            std::set<std::string_view> stale;
+
+            if (settings.incremental)
+            {
+                profiler::scope scope{ profile, "phase", "fingerprints" };
+
+                for (auto&& [ns, members] : c.namespaces())
+                {
+                    fingerprints[ns] = get_namespace_fingerprint(members);
+                }
+
+                // Namespace headers include their parent namespaces, so adding or removing a
+                // namespace regenerates everything, as does changing the options.
+                if (previous.settings != current.settings || previous.namespaces.size() != fingerprints.size() ||
+                    !std::equal(previous.namespaces.begin(), previous.namespaces.end(), fingerprints.begin(), [](auto&& left, auto&& right) { return left.first == right.first; }))
+                {
+                    previous = {};
+                }
+
+                stale = previous.stale_namespaces(fingerprints);
+            }
 
             if (settings.verbose)
             {
@@ -340,14 +616,27 @@ R"(  local               Local ^%WinDir^%\System32\WinMetadata folder
             }
 
             w.flush_to_console();
-            task_group group;
-            group.synchronous(args.exists("synchronous"));
             writer ixx;
             write_preamble(ixx);
             ixx.write("module;\n");
             ixx.write(strings::base_includes);
             ixx.write("\nexport module winrt;\n#define WINRT_EXPORT export\n\n");
 
+            // Each header is written by its own task, and the tasks are added most expensive first
+            // so that large namespaces don't end up on the critical path.
+            struct header_task
+            {
+                size_t cost;
+                std::string_view ns;
+                cache::namespace_members const* members;
+                uint32_t header;
+                std::vector<std::string_view>* depends;
+            };
+
+            std::vector<header_task> header_tasks;
+            std::map<std::string_view, std::array<std::vector<std::string_view>, 4>> depends;
+            uint32_t skipped{};
+
             for (auto&&[ns, members] : c.namespaces())
             {
                 if (!has_projected_types(members) || !settings.projection_filter.includes(members))
@@ -357,23 +646,62 @@ R"(  local               Local ^%WinDir^%\System32\WinMetadata folder
 
                 ixx.write("#include \"winrt/%.h\"\n", ns);
 
-                group.add([&, &ns = ns, &members = members]
+                if (settings.incremental && stale.count(ns) == 0 && has_namespace_headers(ns))
+                {
+                    ++skipped;
+                    continue;
+                }
+
+                auto costs = get_namespace_costs(members);
+                auto& namespace_depends = depends[ns];
+
+                for (uint32_t header = 0; header < costs.size(); ++header)
+                {
+                    header_tasks.push_back({ costs[header], ns, &members, header, &namespace_depends[header] });
+                }
+            }
+
+            std::stable_sort(header_tasks.begin(), header_tasks.end(), [](header_task const& left, header_task const& right)
+            {
+                return left.cost > right.cost;
+            });
+
+            // The group is declared after the state that its tasks write to, so that if anything
+            // below throws, its destructor waits for the tasks before that state is destroyed.
+            task_group group;
+            group.synchronous(args.exists("synchronous"));
+            group.jobs(settings.jobs);
+
+            for (auto&& task : header_tasks)
+            {
+                auto name = task.header < 3 ? w.write_temp("impl/%.%.h", task.ns, task.header) : w.write_temp("%.h", task.ns);
+
+                group.add(name, [&, task, name]
                 {
-                    write_namespace_0_h(ns, members);
-                    write_namespace_1_h(ns, members);
-                    write_namespace_2_h(ns, members);
-                    write_namespace_h(c, ns, members);
+                    profiler::scope scope{ profile, "namespace", name };
+
+                    switch (task.header)
+                    {
+                    case 0: *task.depends = write_namespace_0_h(task.ns, *task.members); break;
+                    case 1: *task.depends = write_namespace_1_h(task.ns, *task.members); break;
+                    case 2: *task.depends = write_namespace_2_h(task.ns, *task.members); break;
+                    default: *task.depends = write_namespace_h(c, task.ns, *task.members); break;
+                    }
                 });
             }
 
             if (settings.base)
             {
+                profiler::scope scope{ profile, "phase", "base.h" };
                 write_base_h();
                 ixx.flush_to_file(settings.output_folder + "winrt/winrt.ixx");
+                current.outputs.insert("winrt/base.h");
+                current.outputs.insert("winrt/winrt.ixx");
             }
 
             if (settings.component)
             {
+                profiler::scope scope{ profile, "phase", "component" };
                 std::vector<TypeDef> classes;
 
                 for (auto&&[ns, members] : c.namespaces())
@@ -390,6 +718,7 @@ R"(  local               Local ^%WinDir^%\System32\WinMetadata folder
                 if (!classes.empty())
                 {
                     write_fast_forward_h(classes);
+                    current.outputs.insert("winrt/fast_forward.h");
                     write_module_g_cpp(classes);
 
                     for (auto&& type : classes)
@@ -402,12 +731,74 @@ R"(  local               Local ^%WinDir^%\System32\WinMetadata folder
                 }
             }
 
-            group.get();
+            {
+                profiler::scope scope{ profile, "phase", "wait for headers" };
+                group.get();
+            }
+
+            if (settings.incremental)
+            {
+                profiler::scope scope{ profile, "phase", "manifest" };
+
+                for (auto&& [ns, fingerprint] : fingerprints)
+                {
+                    auto& entry = current.namespaces[std::string{ ns }];
+                    entry.fingerprint = fingerprint;
+                    auto generated = depends.find(ns);
+
+                    if (generated != depends.end())
+                    {
+                        entry.projected = true;
+
+                        for (auto&& header : generated->second)
+                        {
+                            for (auto&& name : header)
+                            {
+                                if (name != ns)
+                                {
+                                    entry.depends.emplace(name);
+                                }
+                            }
+                        }
+                    }
+                    else if (auto found = previous.namespaces.find(ns); found != previous.namespaces.end())
+                    {
+                        entry.projected = found->second.projected;
+                        entry.depends = found->second.depends;
+                    }
+                }
+
+                current.save(manifest_path);
+            }
+
+            {
+                profiler::scope scope{ profile, "io", "sync" };
+                sync_written_files();
+            }
+
+            std::map<std::string_view, profiler::clock::duration> namespace_times;
+
+            if (profile.enabled())
+            {
+                // The headers are the only tasks in the group, so its timings line up with them.
+                for (size_t index = 0; index < header_tasks.size(); ++index)
+                {
+                    namespace_times[header_tasks[index].ns] += group.timings()[index].elapsed;
+                }
+            }
 
             if (settings.verbose)
             {
+                if (settings.incremental)
+                {
+                    w.write(" skip:  % namespaces unchanged\n", skipped);
+                }
+
+                w.write(" jobs:  % tasks on % threads\n", static_cast<uint32_t>(group.timings().size()), group.thread_count());
                 w.write(" time:  %ms\n", get_elapsed_time(start));
             }
+
+            write_profile(w, namespace_times);
         }
         catch (usage_exception const&)
         {
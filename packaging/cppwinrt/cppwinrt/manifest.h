@@ -0,0 +1,447 @@
+#pragma once
+
+namespace cppwinrt
+{
+    // Incremental generation keeps a manifest in the output folder recording a fingerprint of the
+    // settings, of each input file, and of each projected namespace's metadata along with the
+    // namespaces its headers depend on. A namespace is only regenerated if its own metadata or the
+    // metadata of a namespace it (transitively) depends on has changed.
+
+    inline uint64_t get_file_fingerprint(std::string const& filename)
+    {
+        fingerprint_hash hash;
+        hash.add(file_view{ filename });
+        return hash.value();
+    }
+
+    // Signature blobs refer to types by row, so types are hashed by name to notice a signature
+    // that refers to a different type without its bytes having changed.
+
+    inline void add_fingerprint(fingerprint_hash& hash, TypeSig const& signature);
+
+    inline void add_fingerprint(fingerprint_hash& hash, coded_index<TypeDefOrRef> const& type)
+    {
+        hash.add_word(static_cast<uint64_t>(type.type()));
+
+        switch (type.type())
+        {
+        case TypeDefOrRef::TypeDef:
+            hash.add(type.TypeDef().TypeNamespace());
+            hash.add(type.TypeDef().TypeName());
+            break;
+        case TypeDefOrRef::TypeRef:
+            hash.add(type.TypeRef().TypeNamespace());
+            hash.add(type.TypeRef().TypeName());
+            break;
+        case TypeDefOrRef::TypeSpec:
+        {
+            auto const& signature = type.TypeSpec().Signature();
+            add_fingerprint(hash, signature.GenericTypeInst().GenericType());
+
+            for (auto&& arg : signature.GenericTypeInst().GenericArgs())
+            {
+                add_fingerprint(hash, arg);
+            }
+            break;
+        }
+        }
+    }
+
+    inline void add_fingerprint(fingerprint_hash& hash, TypeSig const& signature)
+    {
+        hash.add_word(signature.is_szarray());
+        hash.add_word(signature.is_array() ? signature.array_rank() : 0);
+        hash.add_word(static_cast<uint64_t>(signature.ptr_count()));
+        hash.add_word(static_cast<uint64_t>(signature.element_type()));
+
+        call(signature.Type(),
+            [&](ElementType type)
+            {
+                hash.add_word(static_cast<uint64_t>(type));
+            },
+            [&](coded_index<TypeDefOrRef> const& type)
+            {
+                add_fingerprint(hash, type);
+            },
+            [&](GenericTypeIndex const& var)
+            {
+                hash.add_word(var.index);
+            },
+            [&](GenericMethodTypeIndex const& var)
+            {
+                hash.add_word(~static_cast<uint64_t>(var.index));
+            },
+            [&](GenericTypeInstSig const& type)
+            {
+                add_fingerprint(hash, type.GenericType());
+
+                for (auto&& arg : type.GenericArgs())
+                {
+                    add_fingerprint(hash, arg);
+                }
+            });
+    }
+
+    inline void add_fingerprint(fingerprint_hash& hash, MethodDefSig const& signature)
+    {
+        hash.add_word(static_cast<uint64_t>(signature.CallConvention()));
+        hash.add_word(signature.GenericParamCount());
+
+        if (signature.ReturnType())
+        {
+            hash.add_word(signature.ReturnType().ByRef());
+            add_fingerprint(hash, signature.ReturnType().Type());
+        }
+
+        for (auto&& param : signature.Params())
+        {
+            hash.add_word(param.ByRef());
+            add_fingerprint(hash, param.Type());
+        }
+    }
+
+    template <typename T>
+    void add_attribute_fingerprints(fingerprint_hash& hash, T const& row)
+    {
+        for (auto&& attribute : row.CustomAttribute())
+        {
+            auto [name_space, name] = attribute.TypeNamespaceAndName();
+            hash.add(name_space);
+            hash.add(name);
+
+            if (attribute.Type().type() == CustomAttributeType::MemberRef)
+            {
+                add_fingerprint(hash, attribute.Type().MemberRef().MethodSignature());
+            }
+            else
+            {
+                add_fingerprint(hash, attribute.Type().MethodDef().Signature());
+            }
+
+            hash.add(attribute.get_database().get_blob(attribute.template get_value<uint32_t>(2)));
+        }
+    }
+
+    inline void add_fingerprint(fingerprint_hash& hash, TypeDef const& type)
+    {
+        hash.add(type.TypeNamespace());
+        hash.add(type.TypeName());
+        hash.add_word(type.Flags().value);
+        hash.add_word(settings.projection_filter.includes(type));
+
+        if (type.Extends())
+        {
+            add_fingerprint(hash, type.Extends());
+        }
+
+        add_attribute_fingerprints(hash, type);
+
+        for (auto&& param : type.GenericParam())
+        {
+            hash.add_word(param.Number());
+            hash.add_word(param.Flags().value);
+            hash.add(param.Name());
+        }
+
+        for (auto&& field : type.FieldList())
+        {
+            hash.add(field.Name());
+            hash.add_word(field.Flags().value);
+            add_fingerprint(hash, field.Signature().Type());
+            add_attribute_fingerprints(hash, field);
+
+            if (auto constant = field.Constant())
+            {
+                hash.add_word(static_cast<uint64_t>(constant.Type()));
+                hash.add(constant.get_database().get_blob(constant.get_value<uint32_t>(2)));
+            }
+        }
+
+        for (auto&& method : type.MethodList())
+        {
+            hash.add(method.Name());
+            hash.add_word(method.Flags().value);
+            hash.add_word(method.ImplFlags().value);
+            add_fingerprint(hash, method.Signature());
+            add_attribute_fingerprints(hash, method);
+
+            for (auto&& param : method.ParamList())
+            {
+                hash.add(param.Name());
+                hash.add_word(param.Sequence());
+                hash.add_word(param.Flags().value);
+                add_attribute_fingerprints(hash, param);
+            }
+        }
+
+        for (auto&& impl : type.InterfaceImpl())
+        {
+            add_fingerprint(hash, impl.Interface());
+            add_attribute_fingerprints(hash, impl);
+        }
+
+        for (auto&& property : type.PropertyList())
+        {
+            hash.add(property.Name());
+            hash.add_word(property.Flags().value);
+            add_fingerprint(hash, property.Type().Type());
+            add_attribute_fingerprints(hash, property);
+
+            for (auto&& semantic : property.MethodSemantic())
+            {
+                hash.add_word(semantic.Semantic().value);
+                hash.add(semantic.Method().Name());
+            }
+        }
+
+        for (auto&& event : type.EventList())
+        {
+            hash.add(event.Name());
+            hash.add_word(event.EventFlags().value);
+            add_fingerprint(hash, event.EventType());
+            add_attribute_fingerprints(hash, event);
+
+            for (auto&& semantic : event.MethodSemantic())
+            {
+                hash.add_word(semantic.Semantic().value);
+                hash.add(semantic.Method().Name());
+            }
+        }
+    }
+
+    inline uint64_t get_namespace_fingerprint(cache::namespace_members const& members)
+    {
+        fingerprint_hash hash;
+
+        // Which of the types are projected depends on -root and -scan as well as on the metadata.
+        for (auto const* types : { &members.interfaces, &members.classes, &members.enums, &members.structs, &members.delegates })
+        {
+            hash.add_word(static_cast<uint32_t>(types->size()));
+
+            for (auto&& type : *types)
+            {
+                hash.add(type.TypeName());
+            }
+        }
+
+        for (auto&& [name, type] : members.types)
+        {
+            add_fingerprint(hash, type);
+        }
+
+        return hash.value();
+    }
+
+    // Fingerprint of the command line options that affect the generated headers, excluding those
+    // that only affect how the tool runs.
+    template <typename Options>
+    uint64_t get_settings_fingerprint(reader const& args, Options const& options)
+    {
+        static constexpr std::string_view ignored[]{ "input", "reference", "verbose", "jobs", "buffer", "synchronous", "incremental", "durable", "cache", "profile" };
+        fingerprint_hash hash;
+        hash.add(CPPWINRT_VERSION_STRING);
+
+        for (auto&& option : options)
+        {
+            if (std::find(std::begin(ignored), std::end(ignored), option.name) != std::end(ignored) || !args.exists(option.name))
+            {
+                continue;
+            }
+
+            hash.add(option.name);
+
+            for (auto&& value : args.values(option.name))
+            {
+                hash.add(value);
+            }
+        }
+
+        return hash.value();
+    }
+
+    struct manifest
+    {
+        struct namespace_entry
+        {
+            uint64_t fingerprint{};
+            bool projected{};
+            std::set<std::string> depends;
+        };
+
+        uint64_t settings{};
+        // Keyed by the option that named the file followed by its path, such as "input a.winmd".
+        std::map<std::string, uint64_t> files;
+        // Files written outside of the namespace headers, relative to the output folder.
+        std::set<std::string> outputs;
+        std::map<std::string, namespace_entry, std::less<>> namespaces;
+
+        static manifest load(std::string const& filename)
+        {
+            manifest result;
+            std::ifstream file(filename);
+            std::string line;
+
+            if (!std::getline(file, line) || line != format_line())
+            {
+                return {};
+            }
+
+            namespace_entry* current{};
+
+            while (std::getline(file, line))
+            {
+                std::istringstream stream(line);
+                std::string kind;
+                uint64_t value{};
+                std::string name;
+                stream >> kind;
+
+                if (kind != "depends" && kind != "output")
+                {
+                    stream >> std::hex >> value;
+                }
+
+                std::getline(stream >> std::ws, name);
+
+                if (stream.fail() || name.empty())
+                {
+                    return {};
+                }
+
+                if (kind == "settings")
+                {
+                    result.settings = value;
+                }
+                else if (kind == "file")
+                {
+                    result.files[name] = value;
+                }
+                else if (kind == "output")
+                {
+                    result.outputs.insert(name);
+                }
+                else if (kind == "namespace" || kind == "metadata")
+                {
+                    current = &result.namespaces[name];
+                    current->fingerprint = value;
+                    current->projected = kind == "namespace";
+                }
+                else if (kind == "depends" && current)
+                {
+                    current->depends.insert(name);
+                }
+                else
+                {
+                    return {};
+                }
+            }
+
+            return result;
+        }
+
+        void save(std::string const& filename) const
+        {
+            writer w;
+            w.write("%\n", format_line());
+            w.write("settings % -\n", hex(settings));
+
+            for (auto&& [name, fingerprint] : files)
+            {
+                w.write("file % %\n", hex(fingerprint), name);
+            }
+
+            for (auto&& name : outputs)
+            {
+                w.write("output %\n", name);
+            }
+
+            for (auto&& [name, entry] : namespaces)
+            {
+                w.write("% % %\n", entry.projected ? "namespace" : "metadata", hex(entry.fingerprint), name);
+
+                for (auto&& depends : entry.depends)
+                {
+                    w.write("depends %\n", depends);
+                }
+            }
+
+            w.flush_to_file(filename);
+        }
+
+        // Returns the namespaces whose headers need to be regenerated because their own
+        // fingerprint or that of a namespace they depend on, directly or not, has changed.
+        std::set<std::string_view> stale_namespaces(std::map<std::string_view, uint64_t> const& fingerprints) const
+        {
+            std::set<std::string_view> changed;
+
+            for (auto&& [name, fingerprint] : fingerprints)
+            {
+                auto entry = namespaces.find(name);
+
+                if (entry == namespaces.end() || entry->second.fingerprint != fingerprint)
+                {
+                    changed.insert(name);
+                }
+            }
+
+            std::set<std::string_view> result;
+
+            for (auto&& [name, fingerprint] : fingerprints)
+            {
+                if (depends_on(name, changed))
+                {
+                    result.insert(name);
+                }
+            }
+
+            return result;
+        }
+
+    private:
+
+        static std::string_view format_line()
+        {
+            return "cppwinrt manifest " CPPWINRT_VERSION_STRING;
+        }
+
+        static std::string hex(uint64_t value)
+        {
+            char buffer[17];
+            snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(value));
+            return buffer;
+        }
+
+        bool depends_on(std::string_view const& name, std::set<std::string_view> const& changed) const
+        {
+            std::set<std::string_view> visited;
+            std::vector<std::string_view> pending{ name };
+
+            while (!pending.empty())
+            {
+                auto next = pending.back();
+                pending.pop_back();
+
+                if (changed.count(next))
+                {
+                    return true;
+                }
+
+                if (!visited.insert(next).second)
+                {
+                    continue;
+                }
+
+                auto entry = namespaces.find(next);
+
+                if (entry == namespaces.end())
+                {
+                    return true;
+                }
+
+                pending.insert(pending.end(), entry->second.depends.begin(), entry->second.depends.end());
+            }
+
+            return false;
+        }
+    };
+}
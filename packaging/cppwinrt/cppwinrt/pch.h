@@ -5,3 +5,4 @@
 #include <winmd_reader.h>
 #include "task_group.h"
 #include "text_writer.h"
+#include "profiler.h"
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace cppwinrt
+{
+    // Records how long each phase of a run takes on each thread, for -profile, and writes them as
+    // a Chrome trace (chrome://tracing or https://ui.perfetto.dev). Until it is enabled, scopes do
+    // nothing beyond checking a flag, so they can be left in place around per-header work.
+    struct profiler
+    {
+        using clock = std::chrono::high_resolution_clock;
+
+        struct event
+        {
+            std::string name;
+            std::string_view category;
+            clock::time_point start;
+            clock::duration elapsed{};
+            uint32_t thread{};
+        };
+
+        struct scope
+        {
+            scope(scope const&) = delete;
+            scope& operator=(scope const&) = delete;
+
+            scope(profiler& owner, std::string_view const& category, std::string_view const& name)
+            {
+                if (owner.enabled())
+                {
+                    m_owner = &owner;
+                    m_category = category;
+                    m_name = name;
+                    m_start = clock::now();
+                }
+            }
+
+            ~scope() noexcept
+            {
+                if (m_owner)
+                {
+                    m_owner->add(m_category, std::move(m_name), m_start, clock::now());
+                }
+            }
+
+        private:
+            profiler* m_owner{};
+            std::string_view m_category;
+            std::string m_name;
+            clock::time_point m_start;
+        };
+
+        // Events are timed relative to the start of the run rather than to when profiling was
+        // enabled, so that the work done before the options were parsed can be recorded too.
+        void enable(clock::time_point start) noexcept
+        {
+            m_start = start;
+            m_enabled = true;
+        }
+
+        bool enabled() const noexcept
+        {
+            return m_enabled;
+        }
+
+        void add(std::string_view const& category, std::string name, clock::time_point start, clock::time_point end) noexcept
+        {
+            if (!m_enabled)
+            {
+                return;
+            }
+
+            try
+            {
+                auto const thread = thread_index();
+                std::lock_guard lock(m_mutex);
+                m_events.push_back({ std::move(name), category, start, end - start, thread });
+            }
+            catch (...)
+            {
+                // A lost event only makes the profile less complete.
+            }
+        }
+
+        // Only safe to call once the threads that record events have finished.
+        std::vector<event> const& events() const noexcept
+        {
+            return m_events;
+        }
+
+        void write_trace(std::string const& filename) const
+        {
+            trace_writer w;
+            w.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+            uint32_t threads{};
+
+            for (auto&& event : m_events)
+            {
+                threads = (std::max)(threads, event.thread + 1);
+            }
+
+            for (uint32_t thread = 0; thread < threads; ++thread)
+            {
+                w.write("{\"ph\":\"M\",\"pid\":1,\"tid\":%,\"name\":\"thread_name\",\"args\":{\"name\":\"%\"}},\n",
+                    thread,
+                    thread == 0 ? "main" : w.write_temp("worker %", thread));
+            }
+
+            bool first = true;
+
+            for (auto&& event : m_events)
+            {
+                if (!first)
+                {
+                    w.write(",\n");
+                }
+
+                first = false;
+                w.write("{\"ph\":\"X\",\"pid\":1,\"tid\":%,\"cat\":\"%\",\"name\":\"",
+                    event.thread,
+                    event.category);
+                w.write_json(event.name);
+                w.write("\",\"ts\":%,\"dur\":%}",
+                    microseconds(event.start - m_start),
+                    microseconds(event.elapsed));
+            }
+
+            w.write("\n]}\n");
+            w.flush_to_file(filename);
+        }
+
+    private:
+
+        struct trace_writer : writer_base<trace_writer>
+        {
+            void write_json(std::string_view const& value)
+            {
+                for (auto c : value)
+                {
+                    if (c == '"' || c == '\\')
+                    {
+                        write('\\');
+                        write(c);
+                    }
+                    else if (static_cast<unsigned char>(c) < 0x20)
+                    {
+                        write_printf("\\u%04X", static_cast<unsigned int>(c));
+                    }
+                    else
+                    {
+                        write(c);
+                    }
+                }
+            }
+        };
+
+        static int64_t microseconds(clock::duration const& duration) noexcept
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        }
+
+        // Threads are numbered in the order they first record an event, which makes the thread
+        // that enables the profiler number zero.
+        static uint32_t thread_index() noexcept
+        {
+            static std::atomic<uint32_t> next{};
+            thread_local uint32_t const index = next++;
+            return index;
+        }
+
+        std::vector<event> m_events;
+        std::mutex m_mutex;
+        clock::time_point m_start;
+        bool m_enabled{};
+    };
+
+    extern profiler profile;
+}
@@ -0,0 +1,349 @@
+#pragma once
+
+namespace cppwinrt
+{
+    // The parts of base.h that write_namespace_special adds to some namespace headers refer to types
+    // from those namespaces by name, so they must be projected whenever the namespace is. An empty
+    // list stands for the whole namespace.
+    static std::map<std::string_view, std::vector<std::string_view>> const& get_special_namespace_types()
+    {
+        static std::map<std::string_view, std::vector<std::string_view>> const types
+        {
+            { "Windows.Foundation", {} },
+            { "Windows.Foundation.Collections", {} },
+            { "Windows.System", { "DispatcherQueue", "DispatcherQueuePriority" } },
+            { "Microsoft.System", { "DispatcherQueue", "DispatcherQueuePriority" } },
+            { "Windows.UI.Core", { "CoreDispatcher", "CoreDispatcherPriority" } },
+            { "Windows.UI.Xaml.Interop", { "TypeKind", "TypeName" } },
+            { "Windows.UI.Xaml.Markup", { "IComponentConnector", "IComponentConnector2" } },
+            { "Microsoft.UI.Xaml.Markup", { "IComponentConnector", "IComponentConnector2" } },
+        };
+
+        return types;
+    }
+
+    // Computes the types that have to be projected for a set of root types to compile: their base
+    // classes, required interfaces and factory interfaces, and every type that appears in their
+    // fields and member signatures, including generic arguments, all followed transitively.
+    struct reachable_types
+    {
+        explicit reachable_types(cache const& c) : m_cache(c)
+        {
+        }
+
+        void add(TypeDef const& type)
+        {
+            if (type && m_types.insert(type).second)
+            {
+                m_pending.push_back(type);
+            }
+        }
+
+        std::set<TypeDef> const& get()
+        {
+            while (!m_pending.empty())
+            {
+                auto type = m_pending.back();
+                m_pending.pop_back();
+                add_members(type);
+                add_special_namespace_types(type.TypeNamespace());
+            }
+
+            return m_types;
+        }
+
+    private:
+
+        void add(coded_index<TypeDefOrRef> const& type)
+        {
+            switch (type.type())
+            {
+            case TypeDefOrRef::TypeDef:
+                add(type.TypeDef());
+                break;
+            case TypeDefOrRef::TypeRef:
+                // System types aren't in the cache and aren't projected anyway.
+                add(find(type.TypeRef()));
+                break;
+            case TypeDefOrRef::TypeSpec:
+                add(type.TypeSpec().Signature().GenericTypeInst());
+                break;
+            }
+        }
+
+        void add(GenericTypeInstSig const& type)
+        {
+            add(type.GenericType());
+
+            for (auto&& arg : type.GenericArgs())
+            {
+                add(arg);
+            }
+        }
+
+        void add(TypeSig const& type)
+        {
+            call(type.Type(),
+                [&](coded_index<TypeDefOrRef> const& type) { add(type); },
+                [&](GenericTypeInstSig const& type) { add(type); },
+                [](auto&&) {});
+        }
+
+        void add_system_type(CustomAttribute const& attribute)
+        {
+            auto const signature = attribute.Value();
+
+            for (auto&& arg : signature.FixedArgs())
+            {
+                if (auto type = std::get_if<ElemSig::SystemType>(&std::get<ElemSig>(arg.value).value))
+                {
+                    add(m_cache.find(type->name));
+                }
+            }
+        }
+
+        void add_members(TypeDef const& type)
+        {
+            if (type.Extends())
+            {
+                add(type.Extends());
+            }
+
+            for (auto&& impl : type.InterfaceImpl())
+            {
+                add(impl.Interface());
+            }
+
+            for (auto&& field : type.FieldList())
+            {
+                add(field.Signature().Type());
+            }
+
+            for (auto&& method : type.MethodList())
+            {
+                auto const& signature = method.Signature();
+
+                if (signature.ReturnType())
+                {
+                    add(signature.ReturnType().Type());
+                }
+
+                for (auto&& param : signature.Params())
+                {
+                    add(param.Type());
+                }
+            }
+
+            for (auto&& event : type.EventList())
+            {
+                add(event.EventType());
+            }
+
+            for (auto&& attribute : type.CustomAttribute())
+            {
+                auto const [ns, name] = attribute.TypeNamespaceAndName();
+
+                if (ns != "Windows.Foundation.Metadata")
+                {
+                    continue;
+                }
+
+                // Factory interfaces are projected along with the class. With the Fast ABI, an
+                // interface's layout depends on the class it belongs to.
+                if (name == "ActivatableAttribute" || name == "StaticAttribute" || name == "ComposableAttribute" ||
+                    (settings.fastabi && name == "ExclusiveToAttribute"))
+                {
+                    add_system_type(attribute);
+                }
+            }
+        }
+
+        void add_special_namespace_types(std::string_view const& ns)
+        {
+            auto special = get_special_namespace_types().find(ns);
+
+            if (special == get_special_namespace_types().end() || !m_special.insert(ns).second)
+            {
+                return;
+            }
+
+            auto members = m_cache.namespaces().find(ns);
+
+            if (members == m_cache.namespaces().end())
+            {
+                return;
+            }
+
+            if (special->second.empty())
+            {
+                for (auto&& [name, type] : members->second.types)
+                {
+                    add(type);
+                }
+            }
+            else
+            {
+                for (auto&& name : special->second)
+                {
+                    add(m_cache.find(ns, name));
+                }
+            }
+        }
+
+        cache const& m_cache;
+        std::set<TypeDef> m_types;
+        std::vector<TypeDef> m_pending;
+        std::set<std::string_view> m_special;
+    };
+
+    // Finds the type that a root names, which may be a type, a generic type without its arity as
+    // it is written in C++, or a member or enumerator of either.
+    static TypeDef find_root_type(cache const& c, std::string_view const& name)
+    {
+        auto find_type = [&](std::string_view const& full_name) -> TypeDef
+        {
+            auto pos = full_name.rfind('.');
+
+            if (pos == std::string_view::npos)
+            {
+                return {};
+            }
+
+            auto const ns = full_name.substr(0, pos);
+            auto const type_name = full_name.substr(pos + 1);
+
+            if (auto type = c.find(ns, type_name))
+            {
+                return type;
+            }
+
+            auto members = c.namespaces().find(ns);
+
+            if (members == c.namespaces().end())
+            {
+                return {};
+            }
+
+            std::string generic_name{ type_name };
+            generic_name += '`';
+            auto generic = members->second.types.lower_bound(generic_name);
+
+            if (generic != members->second.types.end() && starts_with(generic->first, generic_name))
+            {
+                return generic->second;
+            }
+
+            return {};
+        };
+
+        if (auto type = find_type(name))
+        {
+            return type;
+        }
+
+        auto pos = name.rfind('.');
+        return pos == std::string_view::npos ? TypeDef{} : find_type(name.substr(0, pos));
+    }
+
+    // Roots may also be written as they are in C++, such as winrt::Windows::Foundation::Uri.
+    static std::string get_metadata_name(std::string_view name)
+    {
+        if (starts_with(name, "winrt::"))
+        {
+            name.remove_prefix(7);
+        }
+
+        std::string result;
+
+        for (auto pos = name.find("::"); pos != std::string_view::npos; pos = name.find("::"))
+        {
+            result.append(name.substr(0, pos));
+            result += '.';
+            name.remove_prefix(pos + 2);
+        }
+
+        result.append(name);
+        return result;
+    }
+
+    static bool is_source_file(std::string const& filename)
+    {
+        static constexpr std::string_view extensions[]{ ".h", ".hpp", ".hxx", ".inl", ".ipp", ".c", ".cpp", ".cxx", ".cc", ".ixx", ".cppm" };
+        auto const extension = path(filename).extension().string();
+        return std::find(std::begin(extensions), std::end(extensions), extension) != std::end(extensions);
+    }
+
+    static bool is_identifier(char const c) noexcept
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+
+    // Collects the names that consumer source qualifies with winrt::, in metadata form, such as
+    // "Windows.Foundation.Uri" for winrt::Windows::Foundation::Uri. Names that aren't types or
+    // members of types, such as namespaces and winrt::hstring, are simply not found later.
+    static void scan_source_names(std::string const& filename, std::set<std::string>& names)
+    {
+        std::ifstream file(filename, std::ios::in | std::ios::binary);
+
+        if (file.fail())
+        {
+            throw_invalid("Could not read '", filename, "'");
+        }
+
+        std::string const source{ std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        static constexpr std::string_view prefix{ "winrt::" };
+
+        for (auto pos = source.find(prefix); pos != std::string::npos; pos = source.find(prefix, pos))
+        {
+            bool const qualified = pos != 0 && is_identifier(source[pos - 1]);
+            pos += prefix.size();
+
+            if (qualified)
+            {
+                continue;
+            }
+
+            std::string name;
+
+            while (pos < source.size() && is_identifier(source[pos]))
+            {
+                auto const first = pos;
+
+                while (pos < source.size() && is_identifier(source[pos]))
+                {
+                    ++pos;
+                }
+
+                if (!name.empty())
+                {
+                    name += '.';
+                }
+
+                name.append(source, first, pos - first);
+
+                if (source.compare(pos, 2, "::") != 0)
+                {
+                    break;
+                }
+
+                pos += 2;
+            }
+
+            if (!name.empty())
+            {
+                names.insert(std::move(name));
+            }
+        }
+    }
+
+    // Removes every type that the roots don't need from the namespace members, so that only those
+    // are projected and namespaces left without any types are skipped entirely. The types remain
+    // in the cache's type index, so references to them still resolve.
+    static void remove_unreachable_types(cache& c, std::set<TypeDef> const& reachable)
+    {
+        c.remove_types([&](TypeDef const& type)
+        {
+            return reachable.count(type) == 0;
+        });
+    }
+}
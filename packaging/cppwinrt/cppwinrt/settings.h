@@ -13,6 +13,12 @@ namespace cppwinrt
         std::string license_template;
         bool brackets{};
         bool verbose{};
+        uint32_t jobs{};
+        size_t buffer_size{};
+        bool incremental{};
+        bool durable{};
+        std::string cache_file;
+        std::string profile_file;
         bool component{};
         std::string component_folder;
         std::string component_name;
@@ -25,6 +31,8 @@ namespace cppwinrt
 
         std::set<std::string> include;
         std::set<std::string> exclude;
+        std::set<std::string> roots;
+        std::set<std::string> scan;
 
         winmd::reader::filter projection_filter;
         winmd::reader::filter component_filter;
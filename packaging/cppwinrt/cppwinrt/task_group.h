@@ -1,9 +1,37 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
 namespace cppwinrt
 {
+    // Runs tasks on a bounded pool of worker threads. Each worker owns a queue that tasks are
+    // distributed to round-robin; an idle worker steals from the other queues before sleeping.
+    // Tasks start in roughly the order they were added, so callers can add the most expensive
+    // work first. Exceptions are captured per task and rethrown by get() in the order the tasks
+    // were added, so the first failing task wins regardless of which finished first. Synchronous
+    // tasks run within add(), which rethrows their exceptions straight away.
     struct task_group
     {
+        using clock = std::chrono::high_resolution_clock;
+
+        struct task_timing
+        {
+            std::string name;
+            clock::time_point start;
+            clock::duration elapsed{};
+            uint32_t thread{};
+        };
+
         task_group(task_group const&) = delete;
         task_group& operator=(task_group const&) = delete;
 
@@ -11,10 +39,8 @@ namespace cppwinrt
 
         ~task_group() noexcept
         {
-            for (auto&& task : m_tasks)
-            {
-                task.wait();
-            }
+            wait();
+            stop();
         }
 
         void synchronous(bool synchronous) noexcept
@@ -22,37 +48,236 @@ namespace cppwinrt
             m_synchronous = synchronous;
         }
 
+        // Limits the number of worker threads; zero uses one per hardware thread. Only takes
+        // effect before the first task is added.
+        void jobs(uint32_t jobs) noexcept
+        {
+            m_jobs = jobs;
+        }
+
         template <typename T>
         void add(T&& callback)
         {
+            add({}, std::forward<T>(callback));
+        }
+
+        template <typename T>
+        void add(std::string name, T&& callback)
+        {
+            auto& task = *m_tasks.emplace_back(std::make_unique<task_type>());
+            task.callback = std::forward<T>(callback);
+            task.timing.name = std::move(name);
+
             if (m_synchronous)
             {
-                callback();
+                run(task, 0);
+
+                if (task.error)
+                {
+                    std::rethrow_exception(std::exchange(task.error, nullptr));
+                }
+
+                return;
             }
-            else
+
+            start();
+            auto& queue = *m_queues[m_next++ % m_queues.size()];
+
             {
-                m_tasks.push_back(std::async(std::forward<T>(callback)));
+                std::lock_guard lock(queue.mutex);
+                queue.tasks.push_back(&task);
             }
+
+            {
+                std::lock_guard lock(m_mutex);
+                ++m_pending;
+                ++m_queued;
+            }
+
+            m_ready.notify_one();
         }
 
         void get()
         {
+            wait();
+
             auto tasks = std::move(m_tasks);
+            m_timings.clear();
+            m_timings.reserve(tasks.size());
 
             for (auto&& task : tasks)
             {
-                task.wait();
+                m_timings.push_back(std::move(task->timing));
             }
 
             for (auto&& task : tasks)
             {
-                task.get();
+                if (task->error)
+                {
+                    std::rethrow_exception(task->error);
+                }
             }
         }
 
+        // Timing of each task completed by the last call to get(), in the order they were added.
+        std::vector<task_timing> const& timings() const noexcept
+        {
+            return m_timings;
+        }
+
+        uint32_t thread_count() const noexcept
+        {
+            return m_synchronous ? 1 : static_cast<uint32_t>(m_threads.size());
+        }
+
     private:
 
-        std::vector<std::future<void>> m_tasks;
+        struct task_type
+        {
+            std::function<void()> callback;
+            std::exception_ptr error;
+            task_timing timing;
+        };
+
+        struct queue_type
+        {
+            std::mutex mutex;
+            std::deque<task_type*> tasks;
+        };
+
+        static void run(task_type& task, uint32_t thread) noexcept
+        {
+            task.timing.thread = thread;
+            task.timing.start = clock::now();
+
+            try
+            {
+                task.callback();
+            }
+            catch (...)
+            {
+                task.error = std::current_exception();
+            }
+
+            task.timing.elapsed = clock::now() - task.timing.start;
+            task.callback = nullptr;
+        }
+
+        void start()
+        {
+            if (!m_threads.empty())
+            {
+                return;
+            }
+
+            uint32_t count = m_jobs ? m_jobs : std::thread::hardware_concurrency();
+            count = count ? count : 1;
+
+            for (uint32_t index = 0; index < count; ++index)
+            {
+                m_queues.push_back(std::make_unique<queue_type>());
+            }
+
+            for (uint32_t index = 0; index < count; ++index)
+            {
+                m_threads.emplace_back([this, index] { work(index); });
+            }
+        }
+
+        void stop() noexcept
+        {
+            {
+                std::lock_guard lock(m_mutex);
+                m_stopping = true;
+            }
+
+            m_ready.notify_all();
+
+            for (auto&& thread : m_threads)
+            {
+                thread.join();
+            }
+
+            m_threads.clear();
+            m_queues.clear();
+        }
+
+        void wait() noexcept
+        {
+            std::unique_lock lock(m_mutex);
+            m_done.wait(lock, [&] { return m_pending == 0; });
+        }
+
+        task_type* pop(uint32_t index) noexcept
+        {
+            for (size_t offset = 0; offset < m_queues.size(); ++offset)
+            {
+                auto& queue = *m_queues[(index + offset) % m_queues.size()];
+                std::lock_guard lock(queue.mutex);
+
+                if (!queue.tasks.empty())
+                {
+                    auto task = queue.tasks.front();
+                    queue.tasks.pop_front();
+                    return task;
+                }
+            }
+
+            return nullptr;
+        }
+
+        void work(uint32_t index) noexcept
+        {
+            while (true)
+            {
+                {
+                    std::unique_lock lock(m_mutex);
+                    m_ready.wait(lock, [&] { return m_stopping || m_queued != 0; });
+
+                    if (m_queued == 0)
+                    {
+                        return;
+                    }
+
+                    --m_queued;
+                }
+
+                // The queued count was reserved above, so a task is guaranteed to be found in
+                // one of the queues even if another worker emptied this one in the meantime.
+                task_type* task{};
+
+                while (!task)
+                {
+                    task = pop(index);
+                }
+
+                run(*task, index);
+
+                {
+                    std::lock_guard lock(m_mutex);
+
+                    if (--m_pending != 0)
+                    {
+                        continue;
+                    }
+                }
+
+                m_done.notify_all();
+            }
+        }
+
+        std::vector<std::unique_ptr<task_type>> m_tasks;
+        std::vector<task_timing> m_timings;
+        std::vector<std::unique_ptr<queue_type>> m_queues;
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_ready;
+        std::condition_variable m_done;
+        size_t m_pending{};
+        size_t m_queued{};
+        size_t m_next{};
+        uint32_t m_jobs{};
+        bool m_stopping{};
         bool m_synchronous{};
     };
 }
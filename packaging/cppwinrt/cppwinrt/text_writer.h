@@ -1,13 +1,26 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
+#if defined(_WIN32) || defined(_WIN64)
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
 namespace cppwinrt
 {
     inline std::string file_to_string(std::string const& filename)
@@ -27,6 +40,15 @@ namespace cppwinrt
             m_first.reserve(16 * 1024);
         }
 
+        // Bounds the memory used to buffer output. Once the current part grows beyond the budget,
+        // all but its last character is moved to a temporary file, and flush_to_file streams the
+        // result to disk. Only the part written before swap() is ever moved, so the includes
+        // written afterwards can still be prepended. Zero, the default, buffers everything.
+        void memory_budget(size_t bytes) noexcept
+        {
+            m_memory_budget = bytes;
+        }
+
         template <typename... Args>
         void write(std::string_view const& value, Args const&... args)
         {
@@ -41,28 +63,46 @@ namespace cppwinrt
         template <typename... Args>
         std::string write_temp(std::string_view const& value, Args const&... args)
         {
+            // Text measured here is removed again and spilling resumes even if writing throws.
+            struct temp_guard
+            {
+                writer_base& owner;
+                size_t const size;
 #if defined(_DEBUG)
-            bool restore_debug_trace = debug_trace;
-            debug_trace = false;
+                bool const debug_trace;
 #endif
-            auto const size = m_first.size();
 
-            assert(count_placeholders(value) == sizeof...(Args));
-            write_segment(value, args...);
-
-            std::string result{ m_first.data() + size, m_first.size() - size };
-            m_first.resize(size);
+                ~temp_guard() noexcept
+                {
+                    owner.m_first.resize(size);
+                    --owner.m_temp_depth;
+#if defined(_DEBUG)
+                    owner.debug_trace = debug_trace;
+#endif
+                }
+            };
 
 #if defined(_DEBUG)
-            debug_trace = restore_debug_trace;
+            temp_guard guard{ *this, m_first.size(), std::exchange(debug_trace, false) };
+#else
+            temp_guard guard{ *this, m_first.size() };
 #endif
-            return result;
+            ++m_temp_depth;
+
+            assert(count_placeholders(value) == sizeof...(Args));
+            write_segment(value, args...);
+            return { m_first.data() + guard.size, m_first.size() - guard.size };
         }
 
         void write_impl(std::string_view const& value)
         {
             m_first.insert(m_first.end(), value.begin(), value.end());
 
+            if (m_memory_budget && m_first.size() > m_memory_budget)
+            {
+                spill();
+            }
+
 #if defined(_DEBUG)
             if (debug_trace)
             {
@@ -106,32 +146,40 @@ namespace cppwinrt
 
         void write(int const value)
         {
-            write(std::to_string(value));
+            write_integer(value);
         }
 
         void write(unsigned int const value)
         {
-            write(std::to_string(value));
+            write_integer(value);
         }
 
         void write(signed long const value)
         {
-            write(std::to_string(value));
+            write_integer(value);
         }
 
         void write(unsigned long const value)
         {
-            write(std::to_string(value));
+            write_integer(value);
         }
 
         void write(signed long long const value)
         {
-            write(std::to_string(value));
+            write_integer(value);
         }
 
         void write(unsigned long long const value)
         {
-            write(std::to_string(value));
+            write_integer(value);
+        }
+
+        template <typename Integer>
+        void write_integer(Integer const value)
+        {
+            char buffer[24];
+            auto const result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            write(std::string_view{ buffer, static_cast<size_t>(result.ptr - buffer) });
         }
 
         template <typename... Args>
@@ -163,35 +211,71 @@ namespace cppwinrt
         void swap() noexcept
         {
             std::swap(m_second, m_first);
+
+            if (m_spill)
+            {
+                m_spill_second = !m_spill_second;
+            }
         }
 
-        void flush_to_console(bool to_stdout = true) noexcept
+        void flush_to_console(bool to_stdout = true)
         {
-            fprintf(to_stdout ? stdout : stderr, "%.*s", static_cast<int>(m_first.size()), m_first.data());
-            fprintf(to_stdout ? stdout : stderr, "%.*s", static_cast<int>(m_second.size()), m_second.data());
-            m_first.clear();
-            m_second.clear();
+            for_each_chunk([&](std::string_view const& chunk)
+            {
+                fprintf(to_stdout ? stdout : stderr, "%.*s", static_cast<int>(chunk.size()), chunk.data());
+                return true;
+            });
+
+            clear();
         }
 
         void flush_to_file(std::string const& filename)
         {
             if (!file_equal(filename))
             {
+                // The output is written to a uniquely named sibling and renamed over the target, so
+                // that readers and concurrent runs only ever see a complete file and a failure part
+                // way through never leaves a truncated one behind.
+                auto const temp = temp_filename(filename);
                 std::ofstream file;
                 file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
                 try
                 {
-                  file.open(filename, std::ios::out | std::ios::binary);
-                  file.write(m_first.data(), m_first.size());
-                  file.write(m_second.data(), m_second.size());
+                  file.open(temp, std::ios::out | std::ios::binary);
+                  for_each_chunk([&](std::string_view const& chunk)
+                  {
+                      file.write(chunk.data(), chunk.size());
+                      return true;
+                  });
+                  file.close();
+                  static_cast<T*>(this)->file_complete(temp);
+                  std::filesystem::rename(temp, filename);
                 }
                 catch (std::ofstream::failure const& e)
                 {
+                  remove_temp(temp);
                   throw std::filesystem::filesystem_error(e.what(), filename, std::io_errc::stream);
                 }
+                catch (...)
+                {
+                  remove_temp(temp);
+                  throw;
+                }
+
+                static_cast<T*>(this)->file_written(filename);
             }
-            m_first.clear();
-            m_second.clear();
+            clear();
+        }
+
+        // Called once flush_to_file has written and closed the temporary that is about to replace a
+        // file, for derived writers that need to flush it.
+        void file_complete(std::string const&)
+        {
+        }
+
+        // Called after flush_to_file replaces a file, for derived writers that need to track them.
+        void file_written(std::string const&)
+        {
         }
 
         void flush_to_file(std::filesystem::path const& filename)
@@ -202,11 +286,13 @@ namespace cppwinrt
         std::string flush_to_string()
         {
             std::string result;
-            result.reserve(m_first.size() + m_second.size());
-            result.assign(m_first.begin(), m_first.end());
-            result.append(m_second.begin(), m_second.end());
-            m_first.clear();
-            m_second.clear();
+            result.reserve(size());
+            for_each_chunk([&](std::string_view const& chunk)
+            {
+                result.append(chunk);
+                return true;
+            });
+            clear();
             return result;
         }
 
@@ -215,33 +301,162 @@ namespace cppwinrt
             return m_first.empty() ? char{} : m_first.back();
         }
 
-        bool file_equal(std::string const& filename) const
+        bool file_equal(std::string const& filename)
         {
-            if (!std::filesystem::exists(filename))
+            std::error_code error;
+            auto const file_size = std::filesystem::file_size(filename, error);
+
+            if (error || file_size != size())
             {
                 return false;
             }
 
-            auto file = file_to_string(filename);
+            std::ifstream file(filename, std::ios::binary);
 
-            if (file.size() != m_first.size() + m_second.size())
+            return file && for_each_chunk([&](std::string_view const& chunk)
             {
-                return false;
+                return stream_equal(file, chunk);
+            });
+        }
+
+#if defined(_DEBUG)
+        bool debug_trace{};
+#endif
+
+    private:
+
+        struct file_deleter
+        {
+            void operator()(FILE* file) const noexcept
+            {
+                fclose(file);
+            }
+        };
+
+        static std::string temp_filename(std::string const& filename)
+        {
+            static std::atomic<uint32_t> counter{};
+#if defined(_WIN32) || defined(_WIN64)
+            auto const process = _getpid();
+#else
+            auto const process = getpid();
+#endif
+            return filename + "." + std::to_string(process) + "." + std::to_string(++counter) + ".tmp";
+        }
+
+        static void remove_temp(std::string const& temp) noexcept
+        {
+            std::error_code error;
+            std::filesystem::remove(temp, error);
+        }
+
+        size_t size() const noexcept
+        {
+            return m_spill_size + m_first.size() + m_second.size();
+        }
+
+        void clear() noexcept
+        {
+            m_first.clear();
+            m_second.clear();
+            m_spill.reset();
+            m_spill_size = 0;
+            m_spill_second = false;
+        }
+
+        void spill()
+        {
+            // Text measured by write_temp must stay in the buffer, as must anything written
+            // after swap() once the spilled text belongs to the second part.
+            if (m_temp_depth || m_spill_second)
+            {
+                return;
             }
 
-            if (!std::equal(m_first.begin(), m_first.end(), file.begin(), file.begin() + m_first.size()))
+            if (!m_spill)
             {
-                return false;
+                m_spill.reset(tmpfile());
+
+                if (!m_spill)
+                {
+                    throw std::filesystem::filesystem_error("Cannot create temporary file", std::make_error_code(std::errc::io_error));
+                }
+            }
+
+            // Keep the last character so that back() still sees it.
+            auto const size = m_first.size() - 1;
+
+            if (fwrite(m_first.data(), 1, size, m_spill.get()) != size)
+            {
+                throw std::filesystem::filesystem_error("Cannot write temporary file", std::make_error_code(std::errc::io_error));
             }
 
-            return std::equal(m_second.begin(), m_second.end(), file.begin() + m_first.size(), file.end());
+            m_spill_size += size;
+            m_first.erase(m_first.begin(), m_first.begin() + size);
         }
 
-#if defined(_DEBUG)
-        bool debug_trace{};
-#endif
+        // Calls the callback with the buffered output in order, a chunk at a time, stopping early
+        // if the callback returns false.
+        template <typename F>
+        bool for_each_chunk(F const& callback)
+        {
+            auto spilled = [&]
+            {
+                if (!m_spill)
+                {
+                    return true;
+                }
 
-    private:
+                char chunk[16 * 1024];
+                rewind(m_spill.get());
+
+                for (size_t offset = 0; offset < m_spill_size;)
+                {
+                    auto const size = fread(chunk, 1, std::min(sizeof(chunk), m_spill_size - offset), m_spill.get());
+
+                    if (size == 0)
+                    {
+                        throw std::filesystem::filesystem_error("Cannot read temporary file", std::make_error_code(std::errc::io_error));
+                    }
+
+                    if (!callback(std::string_view{ chunk, size }))
+                    {
+                        return false;
+                    }
+
+                    offset += size;
+                }
+
+                fseek(m_spill.get(), 0, SEEK_END);
+                return true;
+            };
+
+            return (m_spill_second || spilled()) &&
+                callback(std::string_view{ m_first.data(), m_first.size() }) &&
+                (!m_spill_second || spilled()) &&
+                callback(std::string_view{ m_second.data(), m_second.size() });
+        }
+
+        // Compares the next part of a file with the chunk, a piece at a time, so that an
+        // unchanged file never has to be read into memory as a whole.
+        static bool stream_equal(std::istream& file, std::string_view const& expected)
+        {
+            char chunk[16 * 1024];
+
+            for (size_t offset = 0; offset < expected.size();)
+            {
+                auto const size = std::min(sizeof(chunk), expected.size() - offset);
+
+                if (!file.read(chunk, size) || memcmp(chunk, expected.data() + offset, size) != 0)
+                {
+                    return false;
+                }
+
+                offset += size;
+            }
+
+            return true;
+        }
 
         static constexpr uint32_t count_placeholders(std::string_view const& format) noexcept
         {
@@ -324,6 +539,11 @@ namespace cppwinrt
 
         std::vector<char> m_second;
         std::vector<char> m_first;
+        std::unique_ptr<FILE, file_deleter> m_spill;
+        size_t m_spill_size{};
+        size_t m_memory_budget{};
+        uint32_t m_temp_depth{};
+        bool m_spill_second{};
     };
 
 
@@ -350,54 +570,50 @@ namespace cppwinrt
 
         void write_indent()
         {
-            for (int32_t i = 0; i < m_indent; i++)
+            static constexpr std::string_view spaces{ "                                " };
+            auto remaining = m_indent > 0 ? static_cast<size_t>(m_indent) * 4 : 0;
+
+            while (remaining)
             {
-                writer_base<T>::write_impl("    ");
+                auto const size = std::min(remaining, spaces.size());
+                writer_base<T>::write_impl(spaces.substr(0, size));
+                remaining -= size;
             }
         }
 
+        // Lines are found with memchr and written whole, so the text between newlines is never
+        // examined, and without any indent the text is written as it is.
         void write_impl(std::string_view const& value)
         {
-            std::string_view::size_type current_pos{ 0 };
-            auto on_new_line = writer_base<T>::back() == '\n';
-
-            while (true)
+            if (m_indent <= 0)
             {
-                const auto pos = value.find('\n', current_pos);
-
-                if (pos == std::string_view::npos)
-                {
-                    if (current_pos < value.size())
-                    {
-                        if (on_new_line)
-                        {
-                            write_indent();
-                        }
-
-                        writer_base<T>::write_impl(value.substr(current_pos));
-                    }
+                writer_base<T>::write_impl(value);
+                return;
+            }
 
-                    return;
-                }
+            auto first = value.data();
+            auto const last = first + value.size();
+            auto on_new_line = writer_base<T>::back() == '\n';
 
-                auto current_line = value.substr(current_pos, pos - current_pos + 1);
-                auto empty_line = current_line[0] == '\n';
+            while (first != last)
+            {
+                auto const newline = static_cast<char const*>(memchr(first, '\n', last - first));
+                auto const line_end = newline ? newline + 1 : last;
 
-                if (on_new_line && !empty_line)
+                if (on_new_line && *first != '\n')
                 {
                     write_indent();
                 }
 
-                writer_base<T>::write_impl(current_line);
-
+                writer_base<T>::write_impl(std::string_view{ first, static_cast<size_t>(line_end - first) });
                 on_new_line = true;
-                current_pos = pos + 1;
+                first = line_end;
             }
         }
 
         void write_impl(char const value)
         {
-            if (writer_base<T>::back() == '\n' && value != '\n')
+            if (m_indent > 0 && value != '\n' && writer_base<T>::back() == '\n')
             {
                 write_indent();
             }
@@ -1,5 +1,10 @@
 #pragma once
 
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace cppwinrt
 {
     using namespace std::filesystem;
@@ -104,10 +109,97 @@ namespace cppwinrt
         return false;
     }
 
+    static void sync_path(std::string const& name, bool directory)
+    {
+#if defined(_WIN32) || defined(_WIN64)
+        // Directory entries are flushed along with the files on NTFS, so only files are synced.
+        if (directory)
+        {
+            return;
+        }
+
+        HANDLE file = CreateFileA(name.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            throw_invalid("Could not open '", name, "' to flush it to disk");
+        }
+
+        bool const flushed = FlushFileBuffers(file);
+        CloseHandle(file);
+#else
+        int file = open(name.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+
+        if (file == -1)
+        {
+            throw_invalid("Could not open '", name, "' to flush it to disk");
+        }
+
+        bool const flushed = fsync(file) == 0;
+        close(file);
+#endif
+
+        if (!flushed)
+        {
+            throw_invalid("Could not flush '", name, "' to disk");
+        }
+    }
+
+    // Folders containing files replaced by a writer during this run, recorded when -durable is
+    // specified so they can be flushed to disk together once generation is complete rather than
+    // after every write.
+    struct written_folders
+    {
+        static void add(std::string const& filename)
+        {
+            auto folder = path(filename).parent_path().string();
+            std::lock_guard lock(mutex());
+            folders().insert(std::move(folder));
+        }
+
+        static std::set<std::string> take()
+        {
+            std::lock_guard lock(mutex());
+            return std::move(folders());
+        }
+
+    private:
+
+        static std::mutex& mutex()
+        {
+            static std::mutex value;
+            return value;
+        }
+
+        static std::set<std::string>& folders()
+        {
+            static std::set<std::string> value;
+            return value;
+        }
+    };
+
     struct writer : writer_base<writer>
     {
         using writer_base<writer>::write;
 
+        // With -durable, each file's data reaches the disk before it replaces the old file, since
+        // not every file system orders a rename after the data written before it.
+        void file_complete(std::string const& temp)
+        {
+            if (settings.durable)
+            {
+                sync_path(temp, false);
+            }
+        }
+
+        void file_written(std::string const& filename)
+        {
+            if (settings.durable)
+            {
+                written_folders::add(filename);
+            }
+        }
+
         struct depends_compare
         {
             bool operator()(TypeDef const& left, TypeDef const& right) const
@@ -594,6 +686,7 @@ namespace cppwinrt
             }
 
             filename += ".h";
+            profiler::scope scope{ profile, "io", "flush" };
             flush_to_file(filename);
         }
     };
@@ -3,6 +3,7 @@
 #if defined(_WIN32)
 #include <windows.h>
 #include <shlwapi.h>
+#include <process.h>
 #else
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -12,16 +13,24 @@
 
 #include <stdexcept>
 #include <assert.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <bitset>
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <future>
 #include <list>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <regex>
 #include <string>
 #include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 #include <set>
@@ -53,6 +62,82 @@ namespace winmd
             throw std::invalid_argument(message);
         }
 
+        // Calls write with a stream on a uniquely named sibling of filename and then renames it over
+        // filename, so that readers only ever see a complete file and threads or processes that
+        // replace the same file never write to the same temporary.
+        template <typename F>
+        void replace_file(std::string const& filename, F const& write)
+        {
+            static std::atomic<uint32_t> counter{};
+#if defined(_WIN32)
+            auto const process = _getpid();
+#else
+            auto const process = getpid();
+#endif
+            auto const temp = filename + "." + std::to_string(process) + "." + std::to_string(++counter) + ".tmp";
+
+            try
+            {
+                std::ofstream file;
+                file.exceptions(std::ofstream::failbit | std::ofstream::badbit);
+                file.open(temp, std::ios::out | std::ios::binary);
+                write(file);
+                file.close();
+                std::filesystem::rename(temp, filename);
+            }
+            catch (...)
+            {
+                std::error_code error;
+                std::filesystem::remove(temp, error);
+                throw;
+            }
+        }
+
+        // Calls callback with each index in [0, count) using up to jobs threads, including the calling
+        // thread, or one per processor if jobs is zero. If any calls throw, the exception from the
+        // lowest index is rethrown once all calls have finished.
+        template <typename F>
+        void parallel_for(size_t const count, uint32_t const jobs, F const& callback)
+        {
+            std::vector<std::exception_ptr> errors(count);
+            std::atomic<size_t> next{};
+
+            auto work = [&]
+            {
+                for (size_t index; (index = next++) < count;)
+                {
+                    try
+                    {
+                        callback(index);
+                    }
+                    catch (...)
+                    {
+                        errors[index] = std::current_exception();
+                    }
+                }
+            };
+
+            {
+                auto const threads = std::min<size_t>(count, std::max(1u, jobs ? jobs : std::thread::hardware_concurrency()));
+                std::vector<std::future<void>> workers;
+
+                for (size_t thread = 1; thread < threads; ++thread)
+                {
+                    workers.push_back(std::async(std::launch::async, work));
+                }
+
+                work();
+            }
+
+            for (auto&& error : errors)
+            {
+                if (error)
+                {
+                    std::rethrow_exception(error);
+                }
+            }
+        }
+
         template <typename T>
         auto c_str(std::basic_string_view<T> const& view) noexcept
         {
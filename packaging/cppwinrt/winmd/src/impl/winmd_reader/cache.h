@@ -1,42 +1,52 @@
 
 namespace winmd::reader
 {
+    // How the files in a cache are loaded. Expanding the tables costs time and memory up front,
+    // so it only pays off when most of the metadata is going to be read.
+    struct cache_options
+    {
+        file_population population{ file_population::eager };
+        table_layout layout{ table_layout::packed };
+        uint32_t jobs{}; // The most threads to load with, or zero for one per processor.
+
+        // Hashes of the contents of the files, in the order they are given, for a caller that has
+        // already computed them. Otherwise a cache file is matched to the files by their sizes and
+        // modification times, so that checking it doesn't read every file in full.
+        std::vector<uint64_t> file_hashes;
+    };
+
     struct cache
     {
         cache() = default;
         cache(cache const&) = delete;
         cache& operator=(cache const&) = delete;
 
+        // The databases are opened and their types filtered in parallel, so the filter may be
+        // called concurrently. They are then merged in the order the files are given, so that the
+        // result is the same as loading them one at a time. The options apply to these files and to
+        // any that are added later.
         template<typename C, typename T = typename C::value_type, typename TypeFilter>
-        explicit cache(C const& files, TypeFilter filter)
+        explicit cache(C const& files, TypeFilter filter, cache_options const& options = {}) : m_options{ options }
         {
-            for (auto&& file : files)
-            {
-                auto& db = m_databases.emplace_back(file, this);
-
-                for (auto&& type : db.TypeDef)
-                {
-                    if (type.Flags().value == 0 || is_nested(type) || !filter(type))
-                    {
-                        continue;
-                    }
-
-                    auto& ns = m_namespaces[type.TypeNamespace()];
-                    ns.types.try_emplace(type.TypeName(), type);
-                }
+            open_databases(files);
+            build(filter);
+        }
 
-                for (auto&& row : db.NestedClass)
-                {
-                    m_nested_types[row.EnclosingType()].push_back(row.NestedType());
-                }
-            }
+        // A cache file holds the classification of the types in a set of files and the resolution
+        // of their TypeRefs, so that a later run over the same files can load them rather than
+        // building them again. It is only used if it was saved for files with the same contents,
+        // in the same order, and for which the filter selected the same types. Otherwise it is
+        // replaced.
+        template<typename C, typename T = typename C::value_type, typename TypeFilter>
+        cache(C const& files, TypeFilter filter, cache_options const& options, std::string const& cache_path) : m_options{ options }
+        {
+            open_databases(files);
+            auto const hashes = cache_path.empty() ? std::vector<uint64_t>{} : hash_databases(filter);
 
-            for (auto&&[namespace_name, members] : m_namespaces)
+            if (!load_cache_file(cache_path, hashes))
             {
-                for (auto&&[name, type] : members.types)
-                {
-                    add_type_to_members(type, members);
-                }
+                build(filter);
+                save_cache_file(cache_path, hashes);
             }
         }
 
@@ -64,21 +74,45 @@ namespace winmd::reader
 
         TypeDef find(std::string_view const& type_namespace, std::string_view const& type_name) const noexcept
         {
-            auto ns = m_namespaces.find(type_namespace);
+            return find(type_namespace, type_name, hash_type_name(type_namespace, type_name));
+        }
 
-            if (ns == m_namespaces.end())
+        TypeDef find(std::string_view const& type_namespace, std::string_view const& type_name, size_t const hash) const noexcept
+        {
+            if (m_index.empty())
             {
                 return {};
             }
 
-            auto type = ns->second.types.find(type_name);
+            auto const mask = m_index.size() - 1;
 
-            if (type == ns->second.types.end())
+            for (auto slot = hash & mask;; slot = (slot + 1) & mask)
             {
-                return {};
+                auto const& entry = m_index[slot];
+
+                if (!entry.type)
+                {
+                    return {};
+                }
+
+                if (entry.hash == hash && entry.type_name == type_name && entry.type_namespace == type_namespace)
+                {
+                    return entry.type;
+                }
+            }
+        }
+
+        // TypeRef resolutions are computed once per database row when the cache is built.
+        TypeDef find(TypeRef const& type) const
+        {
+            auto const& resolved = type.get_database().m_type_refs;
+
+            if (type.index() < resolved.size())
+            {
+                return resolved[type.index()];
             }
 
-            return type->second;
+            return resolve_type_ref(type);
         }
 
         TypeDef find(std::string_view const& type_string) const
@@ -156,12 +190,25 @@ namespace winmd::reader
             remove(members.delegates, name);
         }
 
+        // Like remove_type, for every type that remove returns true for, in one pass over each list.
+        template <typename F>
+        void remove_types(F const& remove)
+        {
+            for (auto&& [ns, members] : m_namespaces)
+            {
+                for (auto* types : { &members.interfaces, &members.classes, &members.enums, &members.structs, &members.delegates })
+                {
+                    types->erase(std::remove_if(types->begin(), types->end(), remove), types->end());
+                }
+            }
+        }
+
         // This won't invalidate any existing database or row_base (e.g. TypeDef) instances
         // However, it may invalidate iterators and references to namespace_members, because those are stored in std::vector
         template <typename TypeFilter>
         void add_database(std::string_view const& file, TypeFilter filter)
         {
-            auto& db = m_databases.emplace_back(file, this);
+            auto& db = m_databases.emplace_back(file, this, m_options.population, m_options.layout);
             for (auto&& type : db.TypeDef)
             {
                 if (type.Flags().value == 0 || is_nested(type) || !filter(type))
@@ -174,13 +221,12 @@ namespace winmd::reader
                 if (inserted)
                 {
                     add_type_to_members(type, ns);
+                    add_type_to_index(type);
                 }
             }
 
-            for (auto&& row : db.NestedClass)
-            {
-                m_nested_types[row.EnclosingType()].push_back(row.NestedType());
-            }
+            // The new types may satisfy references that previously could not be resolved.
+            resolve_type_refs();
         }
 
         void add_database(std::string_view const& file)
@@ -188,18 +234,12 @@ namespace winmd::reader
             add_database(file, default_type_filter{});
         }
 
-        std::vector<TypeDef> const& nested_types(TypeDef const& enclosing_type) const
+        // Each database groups its nested types by enclosing type when it is loaded.
+        auto nested_types(TypeDef const& enclosing_type) const
         {
-            auto it = m_nested_types.find(enclosing_type);
-            if (it != m_nested_types.end())
-            {
-                return it->second;
-            }
-            else
-            {
-                static const std::vector<TypeDef> empty;
-                return empty;
-            }
+            auto const& db = enclosing_type.get_database();
+            auto const first = db.m_nested_types.cbegin();
+            return std::pair{ first + db.m_nested_offsets[enclosing_type.index()], first + db.m_nested_offsets[enclosing_type.index() + 1] };
         }
 
         struct namespace_members
@@ -218,6 +258,369 @@ namespace winmd::reader
 
     private:
 
+        template<typename C>
+        void open_databases(C const& files)
+        {
+            std::vector<std::string_view> paths(std::begin(files), std::end(files));
+            std::vector<std::list<database>> opened(paths.size());
+
+            impl::parallel_for(paths.size(), m_options.jobs, [&](size_t const index)
+            {
+                opened[index].emplace_back(paths[index], this, m_options.population, m_options.layout);
+            });
+
+            for (auto&& db : opened)
+            {
+                // Splicing moves the list node rather than the database, so rows remain valid.
+                m_databases.splice(m_databases.end(), db);
+            }
+        }
+
+        std::vector<database*> get_databases()
+        {
+            std::vector<database*> databases;
+
+            for (auto&& db : m_databases)
+            {
+                databases.push_back(&db);
+            }
+
+            return databases;
+        }
+
+        template <typename TypeFilter>
+        void build(TypeFilter filter)
+        {
+            auto const databases = get_databases();
+            std::vector<std::vector<TypeDef>> types(databases.size());
+
+            impl::parallel_for(databases.size(), m_options.jobs, [&](size_t const index)
+            {
+                for (auto&& type : databases[index]->TypeDef)
+                {
+                    if (type.Flags().value == 0 || is_nested(type) || !filter(type))
+                    {
+                        continue;
+                    }
+
+                    types[index].push_back(type);
+                }
+            });
+
+            for (size_t index = 0; index < databases.size(); ++index)
+            {
+                for (auto&& type : types[index])
+                {
+                    auto& ns = m_namespaces[type.TypeNamespace()];
+                    ns.types.try_emplace(type.TypeName(), type);
+                }
+            }
+
+            // Each namespace's members are categorized independently of the others.
+            std::vector<namespace_members*> members;
+            members.reserve(m_namespaces.size());
+
+            for (auto&&[namespace_name, ns] : m_namespaces)
+            {
+                members.push_back(&ns);
+            }
+
+            impl::parallel_for(members.size(), m_options.jobs, [&](size_t const index)
+            {
+                for (auto&&[name, type] : members[index]->types)
+                {
+                    add_type_to_members(type, *members[index]);
+                }
+            });
+
+            for (auto&& member : members)
+            {
+                for (auto&&[name, type] : member->types)
+                {
+                    add_type_to_index(type);
+                }
+            }
+
+            resolve_type_refs();
+        }
+
+        // The filter can't be compared directly, so the rows it selects are hashed along with the
+        // identity of each file.
+        template <typename TypeFilter>
+        std::vector<uint64_t> hash_databases(TypeFilter const& filter)
+        {
+            auto const databases = get_databases();
+            std::vector<uint64_t> hashes(databases.size());
+            bool const has_file_hashes = m_options.file_hashes.size() == databases.size();
+
+            impl::parallel_for(databases.size(), m_options.jobs, [&](size_t const index)
+            {
+                auto const& db = *databases[index];
+                fingerprint_hash hash;
+
+                if (has_file_hashes)
+                {
+                    hash.add_word(m_options.file_hashes[index]);
+                }
+                else
+                {
+                    std::error_code error;
+                    auto const modified = std::filesystem::last_write_time(db.path(), error);
+                    hash.add(db.path());
+                    hash.add_word(db.m_view.size());
+                    hash.add_word(error ? 0 : static_cast<uint64_t>(modified.time_since_epoch().count()));
+                }
+
+                for (auto&& type : db.TypeDef)
+                {
+                    if (filter(type))
+                    {
+                        hash.add_word(type.index());
+                    }
+                }
+
+                hashes[index] = hash.value();
+            });
+
+            return hashes;
+        }
+
+        static constexpr uint32_t cache_file_magic{ 0x43444d57 }; // "WMDC"
+        static constexpr uint32_t cache_file_version{ 3 };
+
+        // Types are saved as the index of their database and their row plus one, or zero if null.
+        bool load_cache_file(std::string const& path, std::vector<uint64_t> const& hashes)
+        {
+            std::error_code error;
+
+            if (path.empty() || !std::filesystem::is_regular_file(path, error))
+            {
+                return false;
+            }
+
+            try
+            {
+                auto const databases = get_databases();
+                file_view view{ path };
+                uint32_t offset{};
+
+                auto read = [&](auto& value)
+                {
+                    value = view.as<std::remove_reference_t<decltype(value)>>(offset);
+                    offset += sizeof(value);
+                };
+
+                auto read_count = [&]
+                {
+                    uint32_t count{};
+                    read(count);
+
+                    if (count > view.size() - offset)
+                    {
+                        impl::throw_invalid("Invalid cache file");
+                    }
+
+                    return count;
+                };
+
+                auto read_type = [&]
+                {
+                    uint32_t db{};
+                    uint32_t row{};
+                    read(db);
+                    read(row);
+
+                    if (!row)
+                    {
+                        return TypeDef{};
+                    }
+
+                    if (db >= databases.size() || row > databases[db]->TypeDef.size())
+                    {
+                        impl::throw_invalid("Invalid cache file");
+                    }
+
+                    return databases[db]->TypeDef[row - 1];
+                };
+
+                auto read_types = [&](std::vector<TypeDef>& types)
+                {
+                    auto const count = read_count();
+                    types.reserve(count);
+
+                    for (uint32_t index{}; index < count; ++index)
+                    {
+                        types.push_back(read_type());
+                    }
+                };
+
+                uint32_t magic{};
+                uint32_t version{};
+                read(magic);
+                read(version);
+
+                if (magic != cache_file_magic || version != cache_file_version || read_count() != hashes.size())
+                {
+                    return false;
+                }
+
+                for (auto&& expected : hashes)
+                {
+                    uint64_t hash{};
+                    read(hash);
+
+                    if (hash != expected)
+                    {
+                        return false;
+                    }
+                }
+
+                for (auto namespace_count = read_count(); namespace_count; --namespace_count)
+                {
+                    std::vector<TypeDef> types;
+                    read_types(types);
+
+                    if (types.empty())
+                    {
+                        impl::throw_invalid("Invalid cache file");
+                    }
+
+                    auto& members = m_namespaces[types.front().TypeNamespace()];
+
+                    for (auto&& type : types)
+                    {
+                        members.types.try_emplace(type.TypeName(), type);
+                        add_type_to_index(type);
+                    }
+
+                    read_types(members.interfaces);
+                    read_types(members.classes);
+                    read_types(members.enums);
+                    read_types(members.structs);
+                    read_types(members.delegates);
+                    read_types(members.attributes);
+                    read_types(members.contracts);
+                }
+
+                for (auto&& db : databases)
+                {
+                    read_types(db->m_type_refs);
+
+                    if (db->m_type_refs.size() != db->TypeRef.size())
+                    {
+                        impl::throw_invalid("Invalid cache file");
+                    }
+                }
+
+                return true;
+            }
+            catch (std::exception const&)
+            {
+                // A damaged cache file is ignored, and replaced once the cache has been built.
+                m_namespaces.clear();
+                m_index.clear();
+                m_index_count = 0;
+
+                for (auto&& db : m_databases)
+                {
+                    db.m_type_refs.clear();
+                }
+
+                return false;
+            }
+        }
+
+        void save_cache_file(std::string const& path, std::vector<uint64_t> const& hashes) const
+        {
+            if (path.empty())
+            {
+                return;
+            }
+
+            std::map<database const*, uint32_t> indexes;
+
+            for (auto&& db : m_databases)
+            {
+                indexes.emplace(&db, static_cast<uint32_t>(indexes.size()));
+            }
+
+            std::vector<uint8_t> buffer;
+
+            auto write = [&](auto const value)
+            {
+                auto const first = reinterpret_cast<uint8_t const*>(&value);
+                buffer.insert(buffer.end(), first, first + sizeof(value));
+            };
+
+            auto write_count = [&](size_t const count)
+            {
+                write(static_cast<uint32_t>(count));
+            };
+
+            auto write_type = [&](TypeDef const& type)
+            {
+                write(type ? indexes.at(&type.get_database()) : uint32_t{});
+                write(type ? type.index() + 1 : uint32_t{});
+            };
+
+            auto write_types = [&](auto const& types)
+            {
+                write_count(types.size());
+
+                for (auto&& type : types)
+                {
+                    write_type(type);
+                }
+            };
+
+            write(cache_file_magic);
+            write(cache_file_version);
+            write_count(hashes.size());
+
+            for (auto&& hash : hashes)
+            {
+                write(hash);
+            }
+
+            write_count(m_namespaces.size());
+
+            for (auto&&[namespace_name, members] : m_namespaces)
+            {
+                write_count(members.types.size());
+
+                for (auto&&[name, type] : members.types)
+                {
+                    write_type(type);
+                }
+
+                write_types(members.interfaces);
+                write_types(members.classes);
+                write_types(members.enums);
+                write_types(members.structs);
+                write_types(members.delegates);
+                write_types(members.attributes);
+                write_types(members.contracts);
+            }
+
+            for (auto&& db : m_databases)
+            {
+                write_types(db.m_type_refs);
+            }
+
+            // The file is replaced in one step so that a concurrent run never reads half of it. The
+            // cache file is only an optimization, so failing to save it isn't an error.
+            try
+            {
+                impl::replace_file(path, [&](std::ofstream& stream)
+                {
+                    stream.write(reinterpret_cast<char const*>(buffer.data()), buffer.size());
+                });
+            }
+            catch (...)
+            {
+            }
+        }
+
         void add_type_to_members(TypeDef const& type, namespace_members& members)
         {
             switch (get_category(type))
@@ -250,8 +653,125 @@ namespace winmd::reader
             }
         }
 
+        struct index_entry
+        {
+            size_t hash;
+            std::string_view type_namespace;
+            std::string_view type_name;
+            TypeDef type;
+        };
+
+        static size_t hash_type_name(size_t const namespace_hash, size_t const name_hash) noexcept
+        {
+            return namespace_hash ^ (name_hash + 0x9e3779b9 + (namespace_hash << 6) + (namespace_hash >> 2));
+        }
+
+        static size_t hash_type_name(std::string_view const& type_namespace, std::string_view const& type_name) noexcept
+        {
+            return hash_type_name(std::hash<std::string_view>{}(type_namespace), std::hash<std::string_view>{}(type_name));
+        }
+
+        // Names read from a database reuse the hashes computed when its strings were indexed.
+        static size_t hash_type_name(database const& db, std::string_view const& type_namespace, std::string_view const& type_name) noexcept
+        {
+            return hash_type_name(db.get_string_hash(type_namespace), db.get_string_hash(type_name));
+        }
+
+        // The index is an open-addressing table with linear probing, kept at most half full.
+        void add_type_to_index(TypeDef const& type)
+        {
+            if ((m_index_count + 1) * 2 > m_index.size())
+            {
+                std::vector<index_entry> previous(std::max<size_t>(m_index.size() * 2, 1024));
+                previous.swap(m_index);
+                m_index_count = 0;
+
+                for (auto&& entry : previous)
+                {
+                    if (entry.type)
+                    {
+                        insert_index_entry(entry);
+                    }
+                }
+            }
+
+            auto const type_namespace = type.TypeNamespace();
+            auto const type_name = type.TypeName();
+            insert_index_entry({ hash_type_name(type.get_database(), type_namespace, type_name), type_namespace, type_name, type });
+        }
+
+        void insert_index_entry(index_entry const& entry) noexcept
+        {
+            auto const mask = m_index.size() - 1;
+            auto slot = entry.hash & mask;
+
+            while (m_index[slot].type)
+            {
+                slot = (slot + 1) & mask;
+            }
+
+            m_index[slot] = entry;
+            ++m_index_count;
+        }
+
+        TypeDef resolve_type_ref(TypeRef const& type) const
+        {
+            if (type.ResolutionScope().type() != ResolutionScope::TypeRef)
+            {
+                auto const type_namespace = type.TypeNamespace();
+                auto const type_name = type.TypeName();
+                return find(type_namespace, type_name, hash_type_name(type.get_database(), type_namespace, type_name));
+            }
+
+            auto enclosing_type = resolve_type_ref(type.ResolutionScope().TypeRef());
+
+            if (!enclosing_type)
+            {
+                return {};
+            }
+
+            auto const& nested = nested_types(enclosing_type);
+            auto iter = std::find_if(begin(nested), end(nested), [name = type.TypeName()](TypeDef const& arg)
+            {
+                return name == arg.TypeName();
+            });
+
+            if (iter == end(nested))
+            {
+                return {};
+            }
+
+            return *iter;
+        }
+
+        void resolve_type_refs()
+        {
+            std::vector<database*> databases;
+
+            for (auto&& db : m_databases)
+            {
+                databases.push_back(&db);
+            }
+
+            impl::parallel_for(databases.size(), m_options.jobs, [&](size_t const index)
+            {
+                auto& db = *databases[index];
+                std::vector<TypeDef> resolved;
+                resolved.reserve(db.TypeRef.size());
+
+                for (auto&& type : db.TypeRef)
+                {
+                    resolved.push_back(resolve_type_ref(type));
+                }
+
+                db.m_type_refs = std::move(resolved);
+            });
+        }
+
         std::list<database> m_databases;
         std::map<std::string_view, namespace_members> m_namespaces;
-        std::map<TypeDef, std::vector<TypeDef>> m_nested_types;
+        std::vector<index_entry> m_index;
+        size_t m_index_count{};
+        cache_options m_options;
     };
 }
\ No newline at end of file
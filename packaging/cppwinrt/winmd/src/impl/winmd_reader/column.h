@@ -146,41 +146,60 @@ namespace winmd::reader
         return get_parent_row<EventMap, 1>().Parent();
     }
 
-    inline auto TypeDef::PropertyList() const
+    inline MethodDefSig const& MethodDef::Signature() const
+    {
+        return get_database().m_method_signatures.get(index(), get_value<uint32_t>(4), [&]
+        {
+            auto cursor = get_blob(4);
+            return MethodDefSig{ get_table(), cursor };
+        });
+    }
+
+    inline FieldSig const& Field::Signature() const
     {
-        auto const& map = get_database().get_table<PropertyMap>();
-        auto index = this->index() + 1;
-        auto iter = std::find_if(map.begin(), map.end(), [index](PropertyMap const& elem)
+        return get_database().m_field_signatures.get(index(), get_value<uint32_t>(2), [&]
         {
-            return elem.get_value<uint32_t>(0) == index;
+            auto cursor = get_blob(2);
+            return FieldSig{ get_table(), cursor };
         });
-        if (iter == map.end())
+    }
+
+    inline TypeSpecSig const& TypeSpec::Signature() const
+    {
+        return get_database().m_type_spec_signatures.get(index(), get_value<uint32_t>(0), [&]
+        {
+            auto cursor = get_blob(0);
+            return TypeSpecSig{ get_table(), cursor };
+        });
+    }
+
+    inline auto TypeDef::PropertyList() const
+    {
+        auto const row = get_database().m_property_maps[index()];
+
+        if (row == 0)
         {
             auto const& props = get_database().get_table<Property>();
             return std::pair{ props.end(), props.end() };
         }
         else
         {
-            return iter.PropertyList();
+            return get_database().get_table<PropertyMap>()[row - 1].PropertyList();
         }
     }
 
     inline auto TypeDef::EventList() const
     {
-        auto const& map = get_database().get_table<EventMap>();
-        auto index = this->index() + 1;
-        auto iter = std::find_if(map.begin(), map.end(), [index](EventMap const& elem)
-        {
-            return elem.get_value<uint32_t>(0) == index;
-        });
-        if (iter == map.end())
+        auto const row = get_database().m_event_maps[index()];
+
+        if (row == 0)
         {
             auto const& props = get_database().get_table<Event>();
             return std::pair{ props.end(), props.end() };
         }
         else
         {
-            return iter.EventList();
+            return get_database().get_table<EventMap>()[row - 1].EventList();
         }
     }
 
@@ -30,6 +30,20 @@ namespace winmd::reader
         }
     }
 
+    inline attribute_index const& database::get_attribute_index() const
+    {
+        std::call_once(m_attribute_index_once, [this]
+        {
+            for (auto&& attribute : CustomAttribute)
+            {
+                auto const [type_namespace, type_name] = attribute.TypeNamespaceAndName();
+                m_attribute_index.add(type_namespace, type_name, attribute);
+            }
+        });
+
+        return m_attribute_index;
+    }
+
     struct ElemSig
     {
         struct SystemType
@@ -25,58 +25,146 @@ namespace winmd::reader
 {
     struct cache;
 
+    // Signatures are decoded the first time a row's signature is read and then kept for the life
+    // of the database, so reading it again neither parses the blob nor allocates. Rows that share a
+    // blob share its decoded signature.
+    template <typename Sig>
+    struct signature_cache
+    {
+        void resize(uint32_t const rows)
+        {
+            m_rows = std::make_unique<std::atomic<Sig const*>[]>(rows);
+        }
+
+        template <typename Decode>
+        Sig const& get(uint32_t const row, uint32_t const blob, Decode&& decode)
+        {
+            auto& slot = m_rows[row];
+
+            if (auto signature = slot.load(std::memory_order_acquire))
+            {
+                return *signature;
+            }
+
+            std::lock_guard lock(m_mutex);
+            auto found = m_blobs.find(blob);
+
+            if (found == m_blobs.end())
+            {
+                found = m_blobs.emplace(blob, &m_arena.emplace_back(decode())).first;
+            }
+
+            slot.store(found->second, std::memory_order_release);
+            return *found->second;
+        }
+
+    private:
+
+        std::unique_ptr<std::atomic<Sig const*>[]> m_rows;
+        std::mutex m_mutex;
+        std::unordered_map<uint32_t, Sig const*> m_blobs;
+        std::deque<Sig> m_arena;
+    };
+
+    // The CustomAttribute rows of a database grouped by the namespace and name of their attribute
+    // type, so that finding a row's attribute doesn't need to compare the names of all of them.
+    struct attribute_index
+    {
+        // The rows of each attribute type are kept in table order, so they are sorted by parent.
+        std::vector<CustomAttribute> const* find(std::string_view const& type_namespace, std::string_view const& type_name) const
+        {
+            auto found = m_types.find({ type_namespace, type_name });
+            return found == m_types.end() ? nullptr : &found->second;
+        }
+
+        void add(std::string_view const& type_namespace, std::string_view const& type_name, CustomAttribute const& attribute)
+        {
+            m_types[{ type_namespace, type_name }].push_back(attribute);
+        }
+
+    private:
+
+        using key = std::pair<std::string_view, std::string_view>;
+
+        struct key_hash
+        {
+            size_t operator()(key const& value) const noexcept
+            {
+                return std::hash<std::string_view>{}(value.first) * 31 + std::hash<std::string_view>{}(value.second);
+            }
+        };
+
+        std::unordered_map<key, std::vector<CustomAttribute>, key_hash> m_types;
+    };
+
     struct database
     {
         database(database&&) = delete;
         database& operator=(database&&) = delete;
 
+        // Only the headers needed to recognize a database are read, so that probing a folder
+        // doesn't map or page in every file in it.
         static bool is_database(std::string_view const& path)
         {
-            file_view file{ path };
+            file_reader file{ path };
+            impl::image_dos_header dos;
 
-            if (file.size() < sizeof(impl::image_dos_header))
+            if (!file.read(0, dos))
             {
                 return false;
             }
 
-            auto dos = file.as<impl::image_dos_header>();
-
             if (dos.e_signature != 0x5A4D) // IMAGE_DOS_SIGNATURE
             {
                 return false;
             }
 
-            if (file.size() < (dos.e_lfanew + sizeof(impl::image_nt_headers32)))
+            auto const pe_offset = static_cast<uint32_t>(dos.e_lfanew);
+            impl::image_nt_headers32 pe;
+
+            if (!file.read(pe_offset, pe))
             {
                 return false;
             }
 
-            auto pe = file.as<impl::image_nt_headers32>(dos.e_lfanew);
-
             if (pe.FileHeader.NumberOfSections == 0 || pe.FileHeader.NumberOfSections > 100)
             {
                 return false;
             }
-            
-            impl::image_section_header const* sections{};
+
+            uint32_t sections_offset{};
             uint32_t com_virtual_address{};
             if (pe.OptionalHeader.Magic == 0x10B) // PE32
             {
                 com_virtual_address = pe.OptionalHeader.DataDirectory[14].VirtualAddress; // IMAGE_DIRECTORY_ENTRY_COM_DESCRIPTOR
-                sections = &file.as<impl::image_section_header>(dos.e_lfanew + sizeof(impl::image_nt_headers32));
+                sections_offset = pe_offset + sizeof(impl::image_nt_headers32);
             }
             else if (pe.OptionalHeader.Magic == 0x20B) // PE32+
             {
-                auto pe_plus = file.as<impl::image_nt_headers32plus>(dos.e_lfanew);
+                impl::image_nt_headers32plus pe_plus;
+
+                if (!file.read(pe_offset, pe_plus))
+                {
+                    return false;
+                }
+
                 com_virtual_address = pe_plus.OptionalHeader.DataDirectory[14].VirtualAddress; // IMAGE_DIRECTORY_ENTRY_COM_DESCRIPTOR
-                sections = &file.as<impl::image_section_header>(dos.e_lfanew + sizeof(impl::image_nt_headers32plus));
+                sections_offset = pe_offset + sizeof(impl::image_nt_headers32plus);
             }
             else
             {
                 impl::throw_invalid("Invalid optional header magic value");
             }
-            auto sections_end = sections + pe.FileHeader.NumberOfSections;
-            auto section = section_from_rva(sections, sections_end, com_virtual_address);
+
+            std::vector<impl::image_section_header> sections(pe.FileHeader.NumberOfSections);
+
+            if (!file.read(sections_offset, sections.data(), static_cast<uint32_t>(sections.size() * sizeof(impl::image_section_header))))
+            {
+                return false;
+            }
+
+            auto sections_end = sections.data() + sections.size();
+            auto section = section_from_rva(sections.data(), sections_end, com_virtual_address);
 
             if (section == sections_end)
             {
@@ -84,15 +172,14 @@ namespace winmd::reader
             }
 
             auto offset = offset_from_rva(*section, com_virtual_address);
+            impl::image_cor20_header cli;
 
-            auto cli = file.as<impl::image_cor20_header>(offset);
-
-            if (cli.cb != sizeof(impl::image_cor20_header))
+            if (!file.read(offset, cli) || cli.cb != sizeof(impl::image_cor20_header))
             {
                 return false;
             }
 
-            section = section_from_rva(sections, sections_end, cli.MetaData.VirtualAddress);
+            section = section_from_rva(sections.data(), sections_end, cli.MetaData.VirtualAddress);
 
             if (section == sections_end)
             {
@@ -100,8 +187,9 @@ namespace winmd::reader
             }
 
             offset = offset_from_rva(*section, cli.MetaData.VirtualAddress);
+            uint32_t signature{};
 
-            if (file.as<uint32_t>(offset) != 0x424a5342)
+            if (!file.read(offset, signature) || signature != 0x424a5342)
             {
                 return false;
             }
@@ -114,9 +202,12 @@ namespace winmd::reader
             initialize();
         }
 
-        explicit database(std::string_view const& path, cache const* cache = nullptr) : m_view{ path }, m_path{ path }, m_cache{ cache }
+        explicit database(std::string_view const& path, cache const* cache = nullptr, file_population const population = file_population::eager, table_layout const layout = table_layout::packed) :
+            m_view{ path, population },
+            m_path{ path },
+            m_cache{ cache }
         {
-            initialize();
+            initialize(population, layout);
         }
 
         table<reader::TypeRef> TypeRef{ this };
@@ -173,6 +264,12 @@ namespace winmd::reader
 
         std::string_view get_string(uint32_t const index) const
         {
+            if (auto entry = find_string(index))
+            {
+                return { reinterpret_cast<char const*>(m_strings.begin() + index), entry->length };
+            }
+
+            // An index may also refer to the tail of another string.
             auto view = m_strings.seek(index);
             auto last = std::find(view.begin(), view.end(), 0);
 
@@ -184,49 +281,58 @@ namespace winmd::reader
             return { reinterpret_cast<char const*>(view.begin()), static_cast<uint32_t>(last - view.begin()) };
         }
 
+        // The std::hash of a string, which is precomputed for strings returned by get_string.
+        size_t get_string_hash(std::string_view const& value) const noexcept
+        {
+            auto const first = reinterpret_cast<uint8_t const*>(value.data());
+
+            if (first >= m_strings.begin() && first < m_strings.end())
+            {
+                auto entry = find_string(static_cast<uint32_t>(first - m_strings.begin()));
+
+                if (entry && entry->length == value.size())
+                {
+                    return entry->hash;
+                }
+            }
+
+            return std::hash<std::string_view>{}(value);
+        }
+
+        // Built the first time it is needed, which may be on any thread.
+        attribute_index const& get_attribute_index() const;
+
         byte_view get_blob(uint32_t const index) const
         {
-            auto view = m_blobs.seek(index);
-            auto initial_byte = view.as<uint8_t>();
-            uint32_t blob_size_bytes{};
-
-            switch (initial_byte >> 5)
-            {
-            case 0:
-            case 1:
-            case 2:
-            case 3:
-                blob_size_bytes = 1;
-                initial_byte &= 0x7f;
-                break;
-
-            case 4:
-            case 5:
-                blob_size_bytes = 2;
-                initial_byte &= 0x3f;
-                break;
-
-            case 6:
-                blob_size_bytes = 4;
-                initial_byte &= 0x1f;
-                break;
-
-            default:
-                impl::throw_invalid("Invalid blob encoding");
+            // Blobs that were validated when the database was loaded are read without checks.
+            if (index / 64 < m_blob_starts.size() && (m_blob_starts[index / 64] >> (index % 64)) & 1)
+            {
+                auto const data = m_blobs.begin() + index;
+                uint32_t const length = impl::compressed_length[*data >> 5];
+                auto const first = data + length;
+                return { first, first + impl::decode_compressed(data, length) };
             }
 
-            uint32_t blob_size{ initial_byte };
+            auto view = m_blobs.seek(index);
+            uint32_t const length = impl::compressed_length[view.as<uint8_t>() >> 5];
 
-            for (auto&& byte : view.sub(1, blob_size_bytes - 1))
+            if (length == 0)
             {
-                blob_size = (blob_size << 8) + byte;
+                impl::throw_invalid("Invalid blob encoding");
             }
 
-            return { view.sub(blob_size_bytes, blob_size) };
+            auto const size = impl::decode_compressed(view.sub(0, length).begin(), length);
+            return { view.sub(length, size) };
         }
 
     private:
-        void initialize()
+        friend struct cache;
+        friend struct reader::TypeDef;
+        friend struct reader::MethodDef;
+        friend struct reader::Field;
+        friend struct reader::TypeSpec;
+
+        void initialize(file_population const population = file_population::eager, table_layout const layout = table_layout::packed)
         {
             auto dos = m_view.as<impl::image_dos_header>();
 
@@ -324,6 +430,15 @@ namespace winmd::reader
                 view = view.seek(stream_offset(name.data()));
             }
 
+            // When pages are read on demand, the tables are all read to build the cache, but only
+            // the parts of the heaps that the tables refer to are read, so they aren't read ahead.
+            if (population == file_population::lazy)
+            {
+                m_view.advise(tables, file_access::will_need);
+                m_view.advise(m_strings, file_access::random);
+                m_view.advise(m_blobs, file_access::random);
+            }
+
             std::bitset<8> const heap_sizes{ tables.as<uint8_t>(6) };
             uint8_t const string_index_size = heap_sizes.test(0) ? 4 : 2;
             uint8_t const guid_index_size = heap_sizes.test(1) ? 4 : 2;
@@ -479,6 +594,214 @@ namespace winmd::reader
             GenericParam.set_data(view);
             MethodSpec.set_data(view);
             GenericParamConstraint.set_data(view);
+
+            if (layout == table_layout::expanded)
+            {
+                TypeDef.expand();
+                TypeRef.expand();
+                MethodDef.expand();
+                Param.expand();
+                InterfaceImpl.expand();
+                MemberRef.expand();
+                CustomAttribute.expand();
+            }
+
+            index_nested_types();
+            index_map_parents(PropertyMap, m_property_maps);
+            index_map_parents(EventMap, m_event_maps);
+
+            if (population == file_population::eager)
+            {
+                index_strings();
+                validate_blobs();
+            }
+
+            m_method_signatures.resize(MethodDef.size());
+            m_field_signatures.resize(Field.size());
+            m_type_spec_signatures.resize(TypeSpec.size());
+        }
+
+        // Walks the #Blob heap once, checking that the size of each blob is encoded correctly and
+        // that the blob fits in the heap, and records where each valid blob starts. This reads the
+        // whole heap, so it is skipped when the file is paged in on demand.
+        void validate_blobs()
+        {
+            auto const heap_size = m_blobs.size();
+            std::vector<uint64_t> starts((heap_size + 63) / 64);
+
+            for (uint32_t offset{}; offset < heap_size;)
+            {
+                auto const data = m_blobs.begin() + offset;
+                uint32_t const length = impl::compressed_length[*data >> 5];
+
+                if (length == 0 || length > heap_size - offset)
+                {
+                    break;
+                }
+
+                auto const size = impl::decode_compressed(data, length);
+
+                if (size > heap_size - offset - length)
+                {
+                    break;
+                }
+
+                starts[offset / 64] |= 1ull << (offset % 64);
+                offset += length + size;
+            }
+
+            m_blob_starts = std::move(starts);
+        }
+
+        struct string_entry
+        {
+            uint32_t offset{ empty_string_entry };
+            uint32_t length{};
+            size_t hash{};
+        };
+
+        static constexpr uint32_t empty_string_entry{ UINT32_MAX };
+
+        static size_t hash_string_offset(uint32_t const offset) noexcept
+        {
+            return static_cast<size_t>((offset * 0x9e3779b97f4a7c15ull) >> 32);
+        }
+
+        // Each string in the #Strings heap is decoded once, into an open-addressing table keyed by
+        // heap offset and kept at most half full. Like validate_blobs, this reads the whole heap, so
+        // a file paged in on demand finds its strings' terminators and hashes as they are read.
+        void index_strings()
+        {
+            auto const first = m_strings.begin();
+            auto const last = m_strings.end();
+            size_t count{};
+
+            for (auto position = first; position != last; ++count)
+            {
+                position = std::find(position, last, 0);
+
+                if (position != last)
+                {
+                    ++position;
+                }
+            }
+
+            size_t capacity = 16;
+
+            while (capacity < count * 2)
+            {
+                capacity *= 2;
+            }
+
+            m_string_table.assign(capacity, {});
+            auto const mask = capacity - 1;
+
+            for (auto position = first; position != last;)
+            {
+                auto const terminator = std::find(position, last, 0);
+
+                if (terminator == last)
+                {
+                    break;
+                }
+
+                string_entry entry;
+                entry.offset = static_cast<uint32_t>(position - first);
+                entry.length = static_cast<uint32_t>(terminator - position);
+                entry.hash = std::hash<std::string_view>{}({ reinterpret_cast<char const*>(position), entry.length });
+                auto slot = hash_string_offset(entry.offset) & mask;
+
+                while (m_string_table[slot].offset != empty_string_entry)
+                {
+                    slot = (slot + 1) & mask;
+                }
+
+                m_string_table[slot] = entry;
+                position = terminator + 1;
+            }
+        }
+
+        string_entry const* find_string(uint32_t const offset) const noexcept
+        {
+            if (m_string_table.empty())
+            {
+                return nullptr;
+            }
+
+            auto const mask = m_string_table.size() - 1;
+
+            for (auto slot = hash_string_offset(offset) & mask;; slot = (slot + 1) & mask)
+            {
+                auto const& entry = m_string_table[slot];
+
+                if (entry.offset == offset)
+                {
+                    return &entry;
+                }
+
+                if (entry.offset == empty_string_entry)
+                {
+                    return nullptr;
+                }
+            }
+        }
+
+        // Groups the nested types by enclosing type, keeping the order of the NestedClass table, so
+        // that the nested types of TypeDef row i are m_nested_types[m_nested_offsets[i]] up to
+        // m_nested_types[m_nested_offsets[i + 1]].
+        void index_nested_types()
+        {
+            auto const type_count = TypeDef.size();
+            m_nested_offsets.assign(type_count + 2, 0);
+
+            auto is_valid = [&](uint32_t const row)
+            {
+                return NestedClass.get_value<uint32_t>(row, 0) - 1 < type_count && NestedClass.get_value<uint32_t>(row, 1) - 1 < type_count;
+            };
+
+            for (uint32_t row = 0; row < NestedClass.size(); ++row)
+            {
+                if (is_valid(row))
+                {
+                    ++m_nested_offsets[NestedClass.get_value<uint32_t>(row, 1) + 1];
+                }
+            }
+
+            for (uint32_t index = 1; index < m_nested_offsets.size(); ++index)
+            {
+                m_nested_offsets[index] += m_nested_offsets[index - 1];
+            }
+
+            m_nested_types.resize(m_nested_offsets.back());
+
+            for (uint32_t row = 0; row < NestedClass.size(); ++row)
+            {
+                if (is_valid(row))
+                {
+                    auto const enclosing = NestedClass.get_value<uint32_t>(row, 1) - 1;
+                    m_nested_types[m_nested_offsets[enclosing + 1]++] = TypeDef[NestedClass.get_value<uint32_t>(row, 0) - 1];
+                }
+            }
+
+            m_nested_offsets.pop_back();
+        }
+
+        // Records the first PropertyMap or EventMap row (one-based, zero if none) of each TypeDef row,
+        // so that a type's properties and events can be found without scanning the map table.
+        template <typename T>
+        void index_map_parents(table<T> const& map, std::vector<uint32_t>& rows) const
+        {
+            rows.assign(TypeDef.size(), 0);
+
+            for (uint32_t row = 0; row < map.size(); ++row)
+            {
+                auto const parent = map.template get_value<uint32_t>(row, 0);
+
+                if (parent != 0 && parent <= rows.size() && rows[parent - 1] == 0)
+                {
+                    rows[parent - 1] = row + 1;
+                }
+            }
         }
 
         struct stream_range
@@ -531,6 +854,23 @@ namespace winmd::reader
         byte_view m_blobs;
         byte_view m_guids;
         cache const* m_cache;
+
+        // The TypeDef that each TypeRef row resolves to, filled in by the owning cache.
+        std::vector<reader::TypeDef> m_type_refs;
+
+        std::vector<string_entry> m_string_table;
+        std::vector<uint64_t> m_blob_starts;
+        std::vector<uint32_t> m_nested_offsets;
+        std::vector<reader::TypeDef> m_nested_types;
+        std::vector<uint32_t> m_property_maps;
+        std::vector<uint32_t> m_event_maps;
+
+        mutable signature_cache<MethodDefSig> m_method_signatures;
+        mutable signature_cache<FieldSig> m_field_signatures;
+        mutable signature_cache<TypeSpecSig> m_type_spec_signatures;
+
+        mutable std::once_flag m_attribute_index_once;
+        mutable attribute_index m_attribute_index;
     };
 
     template <typename Row>
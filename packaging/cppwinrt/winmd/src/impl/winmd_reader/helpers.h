@@ -15,33 +15,17 @@ namespace winmd::reader
 
     inline auto find(TypeRef const& type)
     {
-        if (type.ResolutionScope().type() != ResolutionScope::TypeRef)
-        {
-            return type.get_database().get_cache().find(type.TypeNamespace(), type.TypeName());
-        }
-        else
-        {
-            auto enclosing_type = find(type.ResolutionScope().TypeRef());
-            if (!enclosing_type)
-            {
-                return TypeDef{};
-            }
-            auto const& nested_types = enclosing_type.get_cache().nested_types(enclosing_type);
-            auto iter = std::find_if(nested_types.begin(), nested_types.end(),
-                [name = type.TypeName()](TypeDef const& arg)
-            {
-                return name == arg.TypeName();
-            });
-            if (iter == nested_types.end())
-            {
-                return TypeDef{};
-            }
-            return *iter;
-        }
+        return type.get_cache().find(type);
     }
 
     inline auto find_required(TypeRef const& type)
     {
+        if (auto definition = find(type))
+        {
+            return definition;
+        }
+
+        // Not found, so walk the references again to report the outermost missing type.
         if (type.ResolutionScope().type() != ResolutionScope::TypeRef)
         {
             return type.get_database().get_cache().find_required(type.TypeNamespace(), type.TypeName());
@@ -50,12 +34,12 @@ namespace winmd::reader
         {
             auto enclosing_type = find_required(type.ResolutionScope().TypeRef());
             auto const& nested_types = enclosing_type.get_cache().nested_types(enclosing_type);
-            auto iter = std::find_if(nested_types.begin(), nested_types.end(),
+            auto iter = std::find_if(begin(nested_types), end(nested_types),
                 [name = type.TypeName()](TypeDef const& arg)
             {
                 return name == arg.TypeName();
             });
-            if (iter == nested_types.end())
+            if (iter == end(nested_types))
             {
                 impl::throw_invalid("Type '", enclosing_type.TypeName(), ".", type.TypeName(), "' could not be found");
             }
@@ -162,17 +162,26 @@ namespace winmd::reader
     template <typename T>
     CustomAttribute get_attribute(T const& row, std::string_view const& type_namespace, std::string_view const& type_name)
     {
-        for (auto&& attribute : row.CustomAttribute())
+        auto const attributes = row.get_database().get_attribute_index().find(type_namespace, type_name);
+
+        if (!attributes)
         {
-            auto pair = attribute.TypeNamespaceAndName();
+            return {};
+        }
 
-            if (pair.first == type_namespace && pair.second == type_name)
-            {
-                return attribute;
-            }
+        auto const parent = row.template coded_index<HasCustomAttribute>();
+
+        auto found = std::lower_bound(attributes->begin(), attributes->end(), parent, [](CustomAttribute const& attribute, coded_index<HasCustomAttribute> const& parent)
+        {
+            return attribute.Parent() < parent;
+        });
+
+        if (found == attributes->end() || found->Parent() != parent)
+        {
+            return {};
         }
 
-        return {};
+        return *found;
     }
 
     enum class category
@@ -106,11 +106,7 @@ namespace winmd::reader
             return get_string(3);
         }
 
-        MethodDefSig Signature() const
-        {
-            auto cursor = get_blob(4);
-            return{ get_table(), cursor };
-        }
+        MethodDefSig const& Signature() const;
 
         auto ParamList() const;
         auto CustomAttribute() const;
@@ -172,11 +168,7 @@ namespace winmd::reader
             return get_string(1);
         }
 
-        auto Signature() const
-        {
-            auto cursor = get_blob(2);
-            return FieldSig{ get_table(), cursor };
-        }
+        FieldSig const& Signature() const;
 
         auto CustomAttribute() const;
         auto Constant() const;
@@ -270,11 +262,7 @@ namespace winmd::reader
     {
         using row_base::row_base;
 
-        TypeSpecSig Signature() const
-        {
-            auto cursor = get_blob(0);
-            return{ get_table(), cursor };
-        }
+        TypeSpecSig const& Signature() const;
 
         auto CustomAttribute() const;
     };
@@ -1,36 +1,39 @@
 
-namespace winmd::reader
+namespace winmd::impl
 {
-    inline uint32_t uncompress_unsigned(byte_view& cursor)
+    // The length of a compressed integer is given by the top three bits of its first byte, with
+    // zero marking an invalid encoding.
+    constexpr uint8_t compressed_length[8]{ 1, 1, 1, 1, 2, 2, 4, 0 };
+    constexpr uint8_t compressed_mask[5]{ 0, 0x7f, 0x3f, 0, 0x1f };
+
+    // Decodes a compressed integer of the given length, whose bytes are known to be available.
+    inline uint32_t decode_compressed(uint8_t const* const data, uint32_t const length) noexcept
     {
-        auto data = cursor.begin();
-        uint32_t value;
-        uint32_t length;
-        if ((*data & 0x80) == 0x00)
-        {
-            length = 1;
-            value = *data;
-        }
-        else if ((*data & 0xc0) == 0x80)
-        {
-            length = 2;
-            value = (*data++ & 0x3f) << 8;
-            value |= *data;
-        }
-        else if ((*data & 0xe0) == 0xc0)
+        uint32_t value = data[0] & compressed_mask[length];
+
+        for (uint32_t index = 1; index < length; ++index)
         {
-            length = 4;
-            value = (*data++ & 0x1f) << 24;
-            value |= *data++ << 16;
-            value |= *data++ << 8;
-            value |= *data;
+            value = (value << 8) | data[index];
         }
-        else
+
+        return value;
+    }
+}
+
+namespace winmd::reader
+{
+    inline uint32_t uncompress_unsigned(byte_view& cursor)
+    {
+        auto const data = cursor.begin();
+        uint32_t const length = cursor ? impl::compressed_length[*data >> 5] : 0;
+
+        if (length == 0)
         {
             impl::throw_invalid("Invalid compressed integer in blob");
         }
+
         cursor = cursor.seek(length);
-        return value;
+        return impl::decode_compressed(data, length);
     }
 
     template <typename T>
@@ -4,6 +4,13 @@ namespace winmd::reader
     struct database;
     struct cache;
 
+    // How the values of the tables that are read most often while projecting are held.
+    enum class table_layout
+    {
+        packed,   // Each value is decoded from the file, according to the width of its column.
+        expanded, // Every value is decoded into a uint32_t column when the file is loaded.
+    };
+
     struct table_base
     {
         explicit table_base(database const* database) noexcept : m_database(database)
@@ -38,7 +45,7 @@ namespace winmd::reader
             XLANG_ASSERT(data_size == 1 || data_size == 2 || data_size == 4 || data_size == 8);
             XLANG_ASSERT(data_size <= sizeof(T));
 
-            if (row > size())
+            if (row >= size())
             {
                 impl::throw_invalid("Invalid row index");
             }
@@ -84,6 +91,7 @@ namespace winmd::reader
         uint32_t m_row_count{};
         uint8_t m_row_size{};
         std::array<column, 6> m_columns{};
+        std::vector<uint32_t> m_values;
 
         void set_row_count(uint32_t const row_count) noexcept
         {
@@ -125,6 +133,46 @@ namespace winmd::reader
             }
         }
 
+        // Expands every column of the table into a uint32_t, at the cost of four bytes per column
+        // per row. The rows are then read from the expanded copy exactly as they are read from the
+        // file, but every column is four bytes wide and aligned, so get_value needs no other path.
+        void expand()
+        {
+            XLANG_ASSERT(m_values.empty());
+            uint8_t columns{};
+
+            while (columns < m_columns.size() && m_columns[columns].size)
+            {
+                XLANG_ASSERT(m_columns[columns].size <= sizeof(uint32_t));
+                ++columns;
+            }
+
+            if (!m_row_count)
+            {
+                return;
+            }
+
+            std::vector<uint32_t> values(static_cast<size_t>(m_row_count) * columns);
+            auto value = values.begin();
+
+            for (uint32_t row{}; row < m_row_count; ++row)
+            {
+                for (uint8_t column{}; column < columns; ++column)
+                {
+                    *value++ = get_value<uint32_t>(row, column);
+                }
+            }
+
+            m_values = std::move(values);
+            m_data = reinterpret_cast<uint8_t const*>(m_values.data());
+            m_row_size = static_cast<uint8_t>(columns * sizeof(uint32_t));
+
+            for (uint8_t column{}; column < columns; ++column)
+            {
+                m_columns[column] = { static_cast<uint8_t>(column * sizeof(uint32_t)), sizeof(uint32_t) };
+            }
+        }
+
         uint8_t index_size() const noexcept
         {
             return m_row_count < (1 << 16) ? 2 : 4;
@@ -144,87 +144,92 @@ namespace winmd::reader
         uint8_t const* m_last{};
     };
 
-    struct file_view : byte_view
+    // A fast, non-cryptographic 64-bit hash for telling whether files and metadata have changed.
+    struct fingerprint_hash
     {
-        file_view(file_view const&) = delete;
-        file_view& operator=(file_view const&) = delete;
-        file_view(file_view&&) noexcept = default;
-        file_view& operator=(file_view&&) noexcept = default;
-
-        file_view(std::string_view const& path) : byte_view{ open_file(path) }, m_backed_by_file{ true }
+        void add(void const* data, size_t size) noexcept
         {
+            auto bytes = static_cast<uint8_t const*>(data);
+            add_word(size);
+
+            for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), bytes += sizeof(uint64_t))
+            {
+                uint64_t word;
+                std::memcpy(&word, bytes, sizeof(word));
+                add_word(word);
+            }
+
+            if (size)
+            {
+                uint64_t word{};
+                std::memcpy(&word, bytes, size);
+                add_word(word);
+            }
         }
 
-        file_view(uint8_t const* const first, uint8_t const* const last) noexcept : byte_view{ first, last }, m_backed_by_file{ false }
+        void add(std::string_view const& value) noexcept
         {
+            add(value.data(), value.size());
         }
 
-        ~file_view() noexcept
+        void add(byte_view const& value) noexcept
         {
-            if (m_backed_by_file)
-            {
-#if defined(_WIN32)
-                UnmapViewOfFile(begin());
-#else
-                munmap(const_cast<void*>(reinterpret_cast<void const*>(begin())), size());
-#endif
-            }
+            add(value.begin(), value.size());
         }
 
-    private:
-
-        bool m_backed_by_file;
+        void add_word(uint64_t word) noexcept
+        {
+            m_value = (m_value ^ word) * 0x100000001b3ull;
+            m_value ^= m_value >> 29;
+        }
 
-#if defined(_WIN32)
-        struct handle
+        uint64_t value() const noexcept
         {
-            HANDLE value{};
+            auto value = m_value * 0xff51afd7ed558ccdull;
+            return value ^ (value >> 32);
+        }
 
-            ~handle() noexcept
-            {
-                if (value)
-                {
-                    CloseHandle(value);
-                }
-            }
+    private:
 
-            explicit operator bool() const noexcept
-            {
-                return value != 0;
-            }
-        };
-#endif
+        uint64_t m_value{ 0xcbf29ce484222325ull };
+    };
 
-        struct file_handle
-        {
+    struct file_handle
+    {
 #if defined(_WIN32)
-            using handle_type = HANDLE;
+        using handle_type = HANDLE;
 #else
-            using handle_type = int;
-            static constexpr handle_type INVALID_HANDLE_VALUE = -1;
+        using handle_type = int;
+        static constexpr handle_type INVALID_HANDLE_VALUE = -1;
 #endif
 
-            handle_type value{ INVALID_HANDLE_VALUE };
+        handle_type value{ INVALID_HANDLE_VALUE };
 
-            ~file_handle() noexcept
+        explicit file_handle(handle_type const value) noexcept : value{ value }
+        {
+        }
+
+        file_handle(file_handle const&) = delete;
+        file_handle& operator=(file_handle const&) = delete;
+
+        ~file_handle() noexcept
+        {
+            if (value != INVALID_HANDLE_VALUE)
             {
-                if (value != INVALID_HANDLE_VALUE)
-                {
 #if defined(_WIN32)
-                    CloseHandle(value);
+                CloseHandle(value);
 #else
-                    close(value);
+                close(value);
 #endif
-                }
             }
+        }
 
-            explicit operator bool() const noexcept
-            {
-                return value != INVALID_HANDLE_VALUE;
-            }
-        };
+        explicit operator bool() const noexcept
+        {
+            return value != INVALID_HANDLE_VALUE;
+        }
 
-        static byte_view open_file(std::string_view const& path)
+        static file_handle open(std::string_view const& path)
         {
 #if defined(_WIN32)
             auto input = impl::c_str(path);
@@ -247,62 +252,232 @@ namespace winmd::reader
                 }
             }
 
-            file_handle file{ CreateFile2(output.data(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr) };
+            auto const value = CreateFile2(output.data(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+#else
+            auto const value = ::open(impl::c_str(path), O_RDONLY, 0);
+#endif
 
-            if (!file)
+            if (value == INVALID_HANDLE_VALUE)
             {
                 impl::throw_invalid("Could not open file '", path, "'");
             }
 
-            LARGE_INTEGER size{};
-            GetFileSizeEx(file.value, &size);
+            return file_handle{ value };
+        }
 
-            if (!size.QuadPart)
+        uint64_t size(std::string_view const& path) const
+        {
+#if defined(_WIN32)
+            LARGE_INTEGER size{};
+            GetFileSizeEx(value, &size);
+            return size.QuadPart;
+#else
+            struct stat st;
+            int ret = fstat(value, &st);
+            if (ret < 0)
             {
-                return{};
+                impl::throw_invalid("Could not open file '", path, "'");
             }
+            return st.st_size;
+#endif
+        }
+    };
 
-            handle mapping{ CreateFileMappingW(file.value, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+    // How the pages of a mapped file are brought into memory.
+    enum class file_population
+    {
+        eager, // The whole file is read when it is mapped.
+        lazy,  // Pages are read when they are first touched.
+    };
 
-            if (!mapping)
+    // Hints about how part of a mapped file is going to be accessed.
+    enum class file_access
+    {
+        random,
+        will_need,
+    };
+
+    struct file_view : byte_view
+    {
+        file_view(file_view const&) = delete;
+        file_view& operator=(file_view const&) = delete;
+        file_view(file_view&&) noexcept = default;
+        file_view& operator=(file_view&&) noexcept = default;
+
+        file_view(std::string_view const& path, file_population const population = file_population::eager) :
+            byte_view{ open_file(path, population) },
+            m_backed_by_file{ true }
+        {
+        }
+
+        file_view(uint8_t const* const first, uint8_t const* const last) noexcept : byte_view{ first, last }, m_backed_by_file{ false }
+        {
+        }
+
+        ~file_view() noexcept
+        {
+            if (m_backed_by_file)
             {
-                impl::throw_invalid("Could not open file '", path, "'");
+#if defined(_WIN32)
+                UnmapViewOfFile(begin());
+#else
+                munmap(const_cast<void*>(reinterpret_cast<void const*>(begin())), size());
+#endif
             }
+        }
 
-            auto const first{ static_cast<uint8_t const*>(MapViewOfFile(mapping.value, FILE_MAP_READ, 0, 0, 0)) };
-            return{ first, first + size.QuadPart };
+        // Passes an access hint for a range within the view on to the kernel. This is only a hint,
+        // so it is ignored where it isn't supported, and failures are ignored.
+        void advise(byte_view const& range, file_access const access) const noexcept
+        {
+#if defined(_WIN32)
+            (void)range;
+            (void)access;
 #else
-            file_handle file{ open(impl::c_str(path), O_RDONLY, 0) };
-            if (!file)
+            if (!m_backed_by_file || !range)
             {
-                impl::throw_invalid("Could not open file '", path, "'");
+                return;
             }
 
-            struct stat st;
-            int ret = fstat(file.value, &st);
-            if (ret < 0)
+            static uintptr_t const page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+            auto const first = reinterpret_cast<uintptr_t>(range.begin()) & ~(page_size - 1);
+            auto const last = reinterpret_cast<uintptr_t>(range.end());
+            int advice{};
+
+            switch (access)
             {
-                impl::throw_invalid("Could not open file '", path, "'");
+            case file_access::random:
+                advice = MADV_RANDOM;
+                break;
+            case file_access::will_need:
+                advice = MADV_WILLNEED;
+                break;
+            }
+
+            madvise(reinterpret_cast<void*>(first), last - first, advice);
+#endif
+        }
+
+    private:
+
+        bool m_backed_by_file;
+
+#if defined(_WIN32)
+        struct handle
+        {
+            HANDLE value{};
+
+            ~handle() noexcept
+            {
+                if (value)
+                {
+                    CloseHandle(value);
+                }
             }
-            if (!st.st_size)
+
+            explicit operator bool() const noexcept
+            {
+                return value != 0;
+            }
+        };
+#endif
+
+        static byte_view open_file(std::string_view const& path, file_population const population)
+        {
+            auto const file = file_handle::open(path);
+            auto const size = file.size(path);
+
+            if (!size)
             {
                 return{};
             }
-            
+
+#if defined(_WIN32)
+            handle mapping{ CreateFileMappingW(file.value, nullptr, PAGE_READONLY, 0, 0, nullptr) };
+
+            if (!mapping)
+            {
+                impl::throw_invalid("Could not open file '", path, "'");
+            }
+
+            // Views are always populated on demand.
+            (void)population;
+            auto const first{ static_cast<uint8_t const*>(MapViewOfFile(mapping.value, FILE_MAP_READ, 0, 0, 0)) };
+            return{ first, first + size };
+#else
 #if defined(__linux__)
-            auto const flags = MAP_PRIVATE | MAP_POPULATE;
+            auto const flags = population == file_population::eager ? MAP_PRIVATE | MAP_POPULATE : MAP_PRIVATE;
 #else
+            (void)population;
             auto const flags = MAP_PRIVATE;
 #endif
             
-            auto const first = static_cast<uint8_t const*>(mmap(nullptr, st.st_size, PROT_READ, flags, file.value, 0));
+            auto const first = static_cast<uint8_t const*>(mmap(nullptr, size, PROT_READ, flags, file.value, 0));
             if (first == MAP_FAILED)
             {
                 impl::throw_invalid("Could not open file '", path, "'");
             }
 
-            return{ first, first + st.st_size };
+            return{ first, first + size };
+#endif
+        }
+    };
+
+    // Reads parts of a file without mapping it, for when only a few of its headers are needed.
+    struct file_reader
+    {
+        explicit file_reader(std::string_view const& path) : m_file{ file_handle::open(path) }, m_size{ m_file.size(path) }
+        {
+        }
+
+        uint64_t size() const noexcept
+        {
+            return m_size;
+        }
+
+        template <typename T>
+        bool read(uint64_t const offset, T& value) const
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            return read(offset, &value, sizeof(T));
+        }
+
+        bool read(uint64_t const offset, void* const buffer, uint32_t const size) const
+        {
+            if (offset + size > m_size)
+            {
+                return false;
+            }
+
+#if defined(_WIN32)
+            OVERLAPPED overlapped{};
+            overlapped.Offset = static_cast<DWORD>(offset);
+            overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+            DWORD bytes_read{};
+            return ReadFile(m_file.value, buffer, size, &bytes_read, &overlapped) && bytes_read == size;
+#else
+            auto first = static_cast<uint8_t*>(buffer);
+            uint32_t total{};
+
+            while (total < size)
+            {
+                auto const bytes_read = pread(m_file.value, first + total, size - total, static_cast<off_t>(offset + total));
+
+                if (bytes_read <= 0)
+                {
+                    return false;
+                }
+
+                total += static_cast<uint32_t>(bytes_read);
+            }
+
+            return true;
 #endif
         }
+
+    private:
+
+        file_handle const m_file;
+        uint64_t const m_size;
     };
 }